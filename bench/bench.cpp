@@ -0,0 +1,206 @@
+// Microbenchmarks of the simulator hot paths
+//   make bench [CONFIG=xxx]
+//   Results are written to stdout as JSON: {"config": .., "benchmarks": [{"name", "ops", "seconds", "ns_per_op", "mops"}, ..]}
+//   The end-to-end benchmarks run on the hierarchy generated from CONFIG (CM_BENCH_HPP, CM_BENCH_NS).
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "cache/cache.hpp"
+#include "cache/msi.hpp"
+#include "cache/index.hpp"
+#include "cache/replace.hpp"
+#include "cache/memory.hpp"
+#include CM_BENCH_HPP
+
+#define CM_BENCH_STR_(x) #x
+#define CM_BENCH_STR(x) CM_BENCH_STR_(x)
+
+struct BenchResult {
+  std::string name;
+  uint64_t ops;
+  double seconds;
+};
+
+static std::vector<BenchResult> results;
+static volatile uint64_t sink; // keep the results of the benchmarked code alive
+
+// run f(n) once with n/10 for warm-up and then time f(ops)
+template<typename F>
+static void bench(const std::string &name, uint64_t ops, F f) {
+  f(ops / 10);
+  auto begin = std::chrono::steady_clock::now();
+  f(ops);
+  auto end = std::chrono::steady_clock::now();
+  results.push_back(BenchResult{name, ops, std::chrono::duration<double>(end - begin).count()});
+  fprintf(stderr, "%-32s %10.1f ns/op\n", name.c_str(), results.back().seconds * 1e9 / ops);
+}
+
+// a random address stream of n blocks within [0, range)
+static std::vector<uint64_t> random_stream(size_t n, uint64_t range) {
+  std::vector<uint64_t> addrs(n);
+  for(auto &a:addrs) a = (cm_get_random_uint64() % range) & ~0x3full;
+  return addrs;
+}
+
+static void write_json() {
+  printf("{\"config\":\"%s\",\"benchmarks\":[", CM_BENCH_STR(CM_BENCH_NS));
+  for(size_t i=0; i<results.size(); i++) {
+    auto &r = results[i];
+    printf("%s\n  {\"name\":\"%s\",\"ops\":%lu,\"seconds\":%.6f,\"ns_per_op\":%.3f,\"mops\":%.3f}",
+           i ? "," : "", r.name.c_str(), r.ops, r.seconds, r.seconds * 1e9 / r.ops, r.ops / r.seconds / 1e6);
+  }
+  printf("\n]}\n");
+}
+
+///////////////////////////////////
+// cache hit and miss paths (hit + replace + hook, as seen by the coherence ports)
+
+template<typename CT>
+static void bench_cache(const std::string &name, uint64_t capacity) {
+  auto cache = new CT();
+  auto hot  = random_stream(1 << 16, capacity / 4);   // fits in the cache
+  auto cold = random_stream(1 << 16, capacity * 64);  // mostly misses
+
+  // fill or replace a block on a miss, then touch it
+  auto access = [cache](uint64_t addr) -> bool {
+    uint32_t ai, s, w;
+    bool hit = cache->hit(addr, &ai, &s, &w);
+    if(!hit) {
+      cache->replace(addr, &ai, &s, &w);
+      auto meta = cache->access(ai, s, w);
+      if(meta->is_valid()) cache->hook_invalid(meta->addr(s), ai, s, w, false, nullptr);
+      meta->init(addr);
+      static_cast<MetadataMSIBase *>(meta)->to_shared();
+    }
+    cache->hook_read(addr, ai, s, w, hit, nullptr);
+    return hit;
+  };
+
+  for(auto a:hot) access(a);
+  bench(name + ".hit", 1 << 22, [&](uint64_t n) {
+    uint64_t h = 0;
+    for(uint64_t i=0; i<n; i++) h += access(hot[i & 0xffff]);
+    sink = h;
+  });
+  bench(name + ".miss", 1 << 20, [&](uint64_t n) {
+    uint64_t h = 0;
+    for(uint64_t i=0; i<n; i++) h += access(cold[i & 0xffff] + (i >> 16) * capacity * 64);
+    sink = h;
+  });
+  delete cache;
+}
+
+///////////////////////////////////
+// replacer updates
+
+template<typename RPC, int IW, int NW>
+static void bench_replacer(const std::string &name) {
+  RPC replacer;
+  std::vector<uint32_t> sets(1 << 16);
+  for(auto &s:sets) s = cm_get_random_uint32() & ((1 << IW) - 1);
+  for(uint32_t s=0; s<(1 << IW); s++)
+    for(uint32_t w=0; w<NW; w++) replacer.access(s, w); // all ways in use
+
+  bench(name + ".access", 1 << 22, [&](uint64_t n) {
+    for(uint64_t i=0; i<n; i++) replacer.access(sets[i & 0xffff], i % NW);
+  });
+  bench(name + ".replace", 1 << 22, [&](uint64_t n) {
+    uint32_t w, h = 0;
+    for(uint64_t i=0; i<n; i++) { replacer.replace(sets[i & 0xffff], &w); h += w; }
+    sink = h;
+  });
+  bench(name + ".invalid_refill", 1 << 20, [&](uint64_t n) {
+    for(uint64_t i=0; i<n; i++) {
+      uint32_t s = sets[i & 0xffff], w;
+      replacer.invalid(s, i % NW);
+      replacer.replace(s, &w);
+      replacer.access(s, w);
+    }
+  });
+}
+
+///////////////////////////////////
+// index hashing
+
+template<typename IDX, int P>
+static void bench_index(const std::string &name) {
+  IDX indexer;
+  auto addrs = random_stream(1 << 16, 1ull << 40);
+  bench(name, 1 << 22, [&](uint64_t n) {
+    uint64_t h = 0;
+    for(uint64_t i=0; i<n; i++) h += indexer.index(addrs[i & 0xffff], i % P);
+    sink = h;
+  });
+}
+
+///////////////////////////////////
+// memory model page lookups
+
+static void bench_memory() {
+  auto mem = new SimpleMemoryModel<Data64B, void>("bench_mem");
+  auto addrs = random_stream(1 << 16, 1ull << 28); // 64K pages
+  Data64B data;
+  for(auto a:addrs) mem->acquire_resp(a, &data, 0, nullptr); // allocate all pages
+  bench("memory.read", 1 << 22, [&](uint64_t n) {
+    for(uint64_t i=0; i<n; i++) mem->acquire_resp(addrs[i & 0xffff], &data, 0, nullptr);
+    sink = data.read(0);
+  });
+  bench("memory.write", 1 << 22, [&](uint64_t n) {
+    for(uint64_t i=0; i<n; i++) mem->writeback_resp(addrs[i & 0xffff], &data, 0, nullptr);
+  });
+}
+
+///////////////////////////////////
+// end-to-end accesses through the generated hierarchy
+
+static void bench_hierarchy() {
+  CM_BENCH_NS::init();
+  std::vector<CoreInterfaceBase *> cores;
+  for(auto c:CM_BENCH_NS::l1) cores.push_back(static_cast<CoreInterfaceBase *>(c->inner));
+  auto ncore = cores.size();
+  uint64_t delay = 0;
+  Data64B data;
+
+  // core i%ncore accesses addr(i), every 4th access is a write
+  auto run = [&](uint64_t n, auto addr) {
+    for(uint64_t i=0; i<n; i++) {
+      auto core = cores[i % ncore];
+      if((i & 3) == 3) core->write(addr(i), &data, &delay);
+      else             core->read(addr(i), &delay);
+    }
+    sink = delay;
+  };
+
+  auto rand = random_stream(1 << 16, 1ull << 26);
+  bench("hierarchy.l1_resident", 1 << 20, [&](uint64_t n) { run(n, [&](uint64_t i) { return ((i / ncore) & 0xff) << 6; }); });
+  bench("hierarchy.sequential",  1 << 19, [&](uint64_t n) { run(n, [&](uint64_t i) { return i << 6; }); });
+  bench("hierarchy.stride_4k",   1 << 19, [&](uint64_t n) { run(n, [&](uint64_t i) { return i << 12; }); });
+  bench("hierarchy.random",      1 << 19, [&](uint64_t n) { run(n, [&](uint64_t i) { return rand[i & 0xffff]; }); });
+  bench("hierarchy.shared",      1 << 19, [&](uint64_t n) { run(n, [&](uint64_t i) { return ((i / 4) & 0x3ff) << 6; }); });
+}
+
+int main() {
+  cm_set_random_seed(0);
+
+  typedef MetadataMSI<48,6,12> l1_meta;
+  typedef MetadataMSI<48,0,6> llc_meta;
+  bench_cache<CacheNorm<6,8,l1_meta,Data64B,IndexNorm<6,6>,ReplaceLRU<6,8>,void,false> >("cache_norm", 64*8*64);
+  bench_cache<CacheSkewed<10,16,2,llc_meta,Data64B,IndexSkewed<10,6,2>,ReplaceLRU<10,16>,void,false> >("cache_skewed", 1024*16*2*64);
+
+  bench_replacer<ReplaceFIFO<10,16>,10,16>("replace_fifo");
+  bench_replacer<ReplaceLRU<10,16>,10,16>("replace_lru");
+
+  bench_index<IndexNorm<10,6>,1>("index_norm");
+  bench_index<IndexSkewed<10,6,2>,2>("index_skewed");
+  bench_index<IndexRandom<10,6>,1>("index_random");
+
+  bench_memory();
+  bench_hierarchy();
+
+  write_json();
+  return 0;
+}
@@ -8,9 +8,13 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <algorithm>
+#include <iostream>
 
 #include "util/random.hpp"
 #include "util/monitor.hpp"
+#include "util/profile.hpp"
+#include "util/checkpoint.hpp"
 #include "cache/index.hpp"
 #include "cache/replace.hpp"
 #include "cache/delay.hpp"
@@ -38,6 +42,10 @@ public:
   virtual bool is_exclusive() const { return false; }
   virtual bool is_dirty() const { return false; }
 
+  // checkpoint
+  virtual void save(CheckpointWriter &ckpt) const {}
+  virtual void restore(CheckpointReader &ckpt) {}
+
   virtual ~CMMetadataBase() {}
 };
 
@@ -47,33 +55,141 @@ public:
   // implement a totally useless base class
   virtual void reset() {} // reset the data block, normally unnecessary
   virtual uint64_t read(unsigned int index) const { return 0; } // read a 64b data
+  virtual void read_block(uint64_t *rdata) const {} // read the whole cache block (the words to be written back if sectored)
   virtual void write(unsigned int index, uint64_t wdata, uint64_t wmask) {} // write a 64b data with wmask
-  virtual void write(uint64_t *wdata) {} // write the whole cache block
-  virtual void copy(const CMDataBase *block) {} // copy the content of block
+  virtual void write(uint64_t *wdata) {} // write the whole cache block (the requested words if sectored)
+  virtual void copy(const CMDataBase *block) {} // copy the content of block (the words it holds)
+
+  // sectored blocks (see DataSectored): masks of the 64b words held by the block and requested by a fill
+  virtual uint64_t present() const { return ~0ull; }
+  virtual uint64_t requested() const { return ~0ull; }
+
+  // checkpoint
+  virtual void save(CheckpointWriter &ckpt) const {}
+  virtual void restore(CheckpointReader &ckpt) {}
 
   virtual ~CMDataBase() {}
 };
 
-// typical 64B data block
-class Data64B : public CMDataBase
+// data block of N bytes (32, 64 or 128), all caches and the memory of a hierarchy use the same block size
+template<int N>
+class DataBlock : public CMDataBase
 {
+  static_assert(N == 32 || N == 64 || N == 128, "DataBlock supports blocks of 32, 64 or 128 bytes");
+
 protected:
-  uint64_t data[8];
+  uint64_t data[N/8];
 
 public:
-  Data64B() : data{0} {}
-  virtual ~Data64B() {}
+  constexpr static uint32_t nword = N/8;
+  constexpr static uint64_t all = (1ull << nword) - 1; // mask of all words
 
-  virtual void reset() { for(auto d:data) d = 0; }
+  DataBlock() : data{0} {}
+  virtual ~DataBlock() {}
+
+  virtual void reset() { for(auto &d:data) d = 0; }
   virtual uint64_t read(unsigned int index) const { return data[index]; }
+  virtual void read_block(uint64_t *rdata) const { for(uint32_t i=0; i<nword; i++) rdata[i] = data[i]; }
   virtual void write(unsigned int index, uint64_t wdata, uint64_t wmask) { data[index] = (data[index] & (~wmask)) | (wdata & wmask); }
-  virtual void write(uint64_t *wdata) { for(int i=0; i<8; i++) data[i] = wdata[i]; }
+  virtual void write(uint64_t *wdata) { for(uint32_t i=0; i<nword; i++) data[i] = wdata[i]; }
   virtual void copy(const CMDataBase *m_block) {
-    auto block = static_cast<const Data64B *>(m_block);
-    for(int i=0; i<8; i++) data[i] = block->data[i];
+    auto block = static_cast<const DataBlock<N> *>(m_block)->data;
+    auto mask = m_block->present();
+    if((mask & all) == all) for(uint32_t i=0; i<nword; i++) data[i] = block[i];
+    else                    for(uint32_t i=0; i<nword; i++) data[i] = (mask >> i) & 1 ? block[i] : data[i]; // a partial (sectored) block
+  }
+  const uint64_t *words() const { return data; } // direct access for block-wide kernels (e.g. compression)
+
+  virtual void save(CheckpointWriter &ckpt) const { ckpt.write(data, sizeof(data)); }
+  virtual void restore(CheckpointReader &ckpt) { ckpt.read(data, sizeof(data)); }
+};
+
+// typical 64B data block
+typedef DataBlock<64> Data64B;
+
+// marker of sectored data blocks
+class DataSectoredBase {};
+
+template<typename DT>
+constexpr bool is_data_sectored = std::is_base_of<DataSectoredBase, DT>::value;
+
+// sectored data block of N bytes in NS sectors, with a valid and a dirty bit per sector (kept as word masks)
+//   Coherence stays per block, sectors only track which words are present and modified.
+//   A fill (between fetch() and fetched()) copies only the requested words and leaves the block clean,
+//   other copies (writebacks, probes and core writes) merge the words held by the source and make them dirty.
+//   Memory receives only the dirty words on a writeback and a reset block holds no words.
+//   The coherence ports fetch the whole block before it is modified, so dirty blocks are always complete.
+template<int N, int NS>
+class DataSectored : public DataBlock<N>, public DataSectoredBase
+{
+  typedef DataBlock<N> BlockT;
+  static_assert(NS >= 1 && BlockT::nword % NS == 0, "the sectors of a DataSectored block must be a whole number of words");
+
+protected:
+  uint64_t valid, dirty, request; // word masks
+  bool filling;
+
+public:
+  constexpr static uint32_t sword = BlockT::nword / NS; // words per sector
+
+  DataSectored() : valid(0), dirty(0), request(0), filling(false) {}
+  virtual ~DataSectored() {}
+
+  // the words of the sector holding addr
+  static uint64_t sector_mask(uint64_t addr) {
+    uint32_t sector = ((addr >> 3) & (BlockT::nword - 1)) / sword;
+    return ((1ull << sword) - 1) << (sector * sword);
+  }
+
+  virtual void reset() { valid = 0; dirty = 0; request = 0; filling = false; }
+  virtual void read_block(uint64_t *rdata) const { for(uint32_t i=0; i<BlockT::nword; i++) if((dirty >> i) & 1) rdata[i] = this->data[i]; }
+  virtual void write(unsigned int index, uint64_t wdata, uint64_t wmask) {
+    BlockT::write(index, wdata, wmask);
+    valid |= 1ull << index; dirty |= 1ull << index;
+  }
+  virtual void write(uint64_t *wdata) {
+    uint64_t mask = filling ? request : BlockT::all;
+    for(uint32_t i=0; i<BlockT::nword; i++) this->data[i] = (mask >> i) & 1 ? wdata[i] : this->data[i];
+    valid |= mask;
+    if(!filling) dirty |= mask;
+  }
+  virtual void copy(const CMDataBase *m_block) { copy(m_block, BlockT::all); }
+  // copy the words of mask (a core write of a sector)
+  void copy(const CMDataBase *m_block, uint64_t mask) {
+    auto block = static_cast<const BlockT *>(m_block)->words();
+    mask &= m_block->present() & (filling ? request : BlockT::all);
+    for(uint32_t i=0; i<BlockT::nword; i++) this->data[i] = (mask >> i) & 1 ? block[i] : this->data[i];
+    valid |= mask;
+    if(!filling) dirty |= mask;
+  }
+
+  virtual uint64_t present() const { return valid; }
+  virtual uint64_t requested() const { return filling ? request : ~0ull; }
+  uint64_t get_dirty() const { return dirty; }
+
+  // fill the words of mask missing in this block
+  void fetch(uint64_t mask) { request = mask & BlockT::all & ~valid; filling = true; }
+  void fetched() { request = 0; filling = false; }
+  bool missing(uint64_t mask) const { return mask & BlockT::all & ~valid; }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    BlockT::save(ckpt);
+    ckpt.put<uint64_t>(valid); ckpt.put<uint64_t>(dirty);
+  }
+  virtual void restore(CheckpointReader &ckpt) {
+    BlockT::restore(ckpt);
+    valid = ckpt.get<uint64_t>(); dirty = ckpt.get<uint64_t>();
+    request = 0; filling = false;
   }
 };
 
+// residency of an address reported by a batch query
+struct CMResidency {
+  int32_t  level;    // -1 if not cached, 0 in a single cache query, the hierarchy level in a hierarchy query
+  uint32_t cache;    // index of the cache in its hierarchy level
+  uint32_t ai, s, w; // cache array (partition), set and way
+};
+
 //////////////// define cache array ////////////////////
 
 // base class for a cache array:
@@ -89,6 +205,10 @@ public:
   virtual bool hit(uint64_t addr, uint32_t s, uint32_t *w) const = 0;
   virtual CMMetadataBase * get_meta(uint32_t s, uint32_t w) = 0;
   virtual CMDataBase * get_data(uint32_t s, uint32_t w) = 0;
+
+  // checkpoint
+  virtual void save(CheckpointWriter &ckpt) const = 0;
+  virtual bool restore(CheckpointReader &ckpt) = 0;
 };
 
 // normal set associative cache array
@@ -130,6 +250,24 @@ public:
     return false;
   }
 
+  // non-virtual versions of hit() for batch queries
+  bool lookup(uint64_t addr, uint32_t s, uint32_t *w) const {
+    auto set = meta.data() + s*NW;
+    for(int i=0; i<NW; i++)
+      if(set[i]->MT::match(addr)) {
+        *w = i;
+        return true;
+      }
+    return false;
+  }
+  void prefetch(uint32_t s) const { for(int i=0; i<NW; i++) __builtin_prefetch(meta[s*NW + i]); }
+
+  // exchange the block objects of way w in set s with *m and *d, to move blocks between arrays without copying
+  void exchange(uint32_t s, uint32_t w, MT **m, DT **d) {
+    std::swap(meta[s*NW + w], *m);
+    if constexpr (!std::is_void<DT>::value) std::swap(data[s*NW + w], *d);
+  }
+
   virtual CMMetadataBase * get_meta(uint32_t s, uint32_t w) { return meta[s*NW + w]; }
   virtual CMDataBase * get_data(uint32_t s, uint32_t w) {
     if constexpr (std::is_void<DT>::value) {
@@ -137,6 +275,157 @@ public:
     } else
       return data[s*NW + w];
   }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    ckpt.put<uint32_t>(nset);
+    ckpt.put<uint32_t>(NW);
+    for(auto m:meta) m->save(ckpt);
+    if constexpr (!std::is_void<DT>::value) for(auto d:data) d->save(ckpt);
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!ckpt.expect<uint32_t>(nset, "number of sets") || !ckpt.expect<uint32_t>(NW, "number of ways")) return false;
+    for(auto m:meta) m->restore(ckpt);
+    if constexpr (!std::is_void<DT>::value) for(auto d:data) d->restore(ckpt);
+    return ckpt.good();
+  }
+};
+
+// sparse set associative cache array for huge caches (e.g. DRAM caches)
+// IW: index width, NW: number of ways, MT: metadata type, DT: data type (void if not in use)
+//   The blocks of a set are allocated when the set is first accessed by get_meta() or get_data(), while
+//   hit() and lookup() miss in an untouched set without allocating it, so the array is created instantly
+//   and takes memory proportional to the touched sets (the table of sets is zeroed on demand by the OS).
+//   Touched sets take their blocks from pools of PS sets (allocated and freed as a whole) and are found
+//   through the table of sets, one more indirection than CacheArrayNorm.
+//   As blocks are not freed individually, exchange() moves them only between sparse arrays.
+template<int IW, int NW, typename MT, typename DT,
+         typename = typename std::enable_if<std::is_base_of<CMMetadataBase, MT>::value>::type, // MT <- CMMetadataBase
+         typename = typename std::enable_if<std::is_base_of<CMDataBase, DT>::value || std::is_void<DT>::value>::type> // DT <- CMDataBase or void
+class CacheArraySparse : public CacheArrayBase
+{
+  typedef typename std::conditional<std::is_void<DT>::value, char, DT>::type DataT;
+  constexpr static uint32_t PS = IW < 6 ? 1ul << IW : 64; // sets per pool
+
+protected:
+  MT ***meta;                    // ways of each set, null if not allocated (zeroed lazily by the OS)
+  DataT ***data;                 // ways of each set, null if DT is void
+  std::vector<MT *> meta_pool;   // pools of blocks and of the way tables pointing to them
+  std::vector<MT **> meta_ways;
+  std::vector<DataT *> data_pool;
+  std::vector<DataT **> data_ways;
+  std::vector<uint32_t> touched; // allocated sets in the order of allocation
+
+  void allocate(uint32_t s) {
+    auto p = touched.size() % PS;
+    if(p == 0) {
+      meta_pool.push_back(new MT[PS*NW]);
+      meta_ways.push_back(new MT *[PS*NW]);
+      if constexpr (!std::is_void<DT>::value) {
+        data_pool.push_back(new DT[PS*NW]);
+        data_ways.push_back(new DT *[PS*NW]);
+      }
+    }
+    meta[s] = meta_ways.back() + p*NW;
+    for(int i=0; i<NW; i++) meta[s][i] = meta_pool.back() + p*NW + i;
+    if constexpr (!std::is_void<DT>::value) {
+      data[s] = data_ways.back() + p*NW;
+      for(int i=0; i<NW; i++) data[s][i] = data_pool.back() + p*NW + i;
+    }
+    touched.push_back(s);
+  }
+
+  MT **ways(uint32_t s) {
+    if(!meta[s]) allocate(s);
+    return meta[s];
+  }
+
+public:
+  const uint32_t nset = 1ul<<IW;  // number of sets
+
+  CacheArraySparse(std::string name = "") : CacheArrayBase(name), data(nullptr) {
+    meta = static_cast<MT ***>(calloc(nset, sizeof(MT **)));
+    if constexpr (!std::is_void<DT>::value) data = static_cast<DataT ***>(calloc(nset, sizeof(DataT **)));
+  }
+
+  virtual ~CacheArraySparse() {
+    free(meta);
+    free(data);
+    for(auto m:meta_pool) delete [] m;
+    for(auto m:meta_ways) delete [] m;
+    for(auto d:data_pool) delete [] d;
+    for(auto d:data_ways) delete [] d;
+  }
+
+  virtual bool hit(uint64_t addr, uint32_t s, uint32_t *w) const { return lookup(addr, s, w); }
+
+  // non-virtual versions of hit() for batch queries
+  bool lookup(uint64_t addr, uint32_t s, uint32_t *w) const {
+    auto set = meta[s];
+    if(set)
+      for(int i=0; i<NW; i++)
+        if(set[i]->MT::match(addr)) {
+          *w = i;
+          return true;
+        }
+    return false;
+  }
+  void prefetch(uint32_t s) const {
+    auto set = meta[s];
+    if(set) for(int i=0; i<NW; i++) __builtin_prefetch(set[i]);
+  }
+
+  // exchange the block objects of way w in set s with *m and *d, to move blocks between arrays without copying
+  void exchange(uint32_t s, uint32_t w, MT **m, DT **d) {
+    std::swap(ways(s)[w], *m);
+    if constexpr (!std::is_void<DT>::value) std::swap(data[s][w], *d);
+  }
+
+  virtual CMMetadataBase * get_meta(uint32_t s, uint32_t w) { return ways(s)[w]; }
+  virtual CMDataBase * get_data(uint32_t s, uint32_t w) {
+    if constexpr (std::is_void<DT>::value) {
+      return nullptr;
+    } else {
+      if(!data[s]) allocate(s);
+      return data[s][w];
+    }
+  }
+
+  uint64_t get_allocated_sets() const { return touched.size(); }
+
+  // checkpoint: the allocated sets (in ascending order) and their blocks
+  virtual void save(CheckpointWriter &ckpt) const {
+    ckpt.put<uint32_t>(nset);
+    ckpt.put<uint32_t>(NW);
+    std::vector<uint32_t> sets(touched);
+    std::sort(sets.begin(), sets.end());
+    ckpt.put<uint32_t>(sets.size());
+    for(auto s:sets) {
+      ckpt.put<uint32_t>(s);
+      for(int i=0; i<NW; i++) meta[s][i]->save(ckpt);
+      if constexpr (!std::is_void<DT>::value) for(int i=0; i<NW; i++) data[s][i]->save(ckpt);
+    }
+  }
+
+  // sets allocated but not in the checkpoint are returned to the initial state
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!ckpt.expect<uint32_t>(nset, "number of sets") || !ckpt.expect<uint32_t>(NW, "number of ways")) return false;
+    std::vector<bool> restored(nset, false);
+    for(uint32_t n = ckpt.get<uint32_t>(); n > 0 && ckpt.good(); n--) {
+      auto s = ckpt.get<uint32_t>();
+      if(!ckpt.good() || s >= nset) return false;
+      auto m = ways(s);
+      for(int i=0; i<NW; i++) m[i]->restore(ckpt);
+      if constexpr (!std::is_void<DT>::value) for(int i=0; i<NW; i++) data[s][i]->restore(ckpt);
+      restored[s] = true;
+    }
+    for(auto s:touched)
+      if(!restored[s]) {
+        for(int i=0; i<NW; i++) *meta[s][i] = MT();
+        if constexpr (!std::is_void<DT>::value) for(int i=0; i<NW; i++) *data[s][i] = DT();
+      }
+    return ckpt.good();
+  }
 };
 
 //////////////// define cache ////////////////////
@@ -150,16 +439,28 @@ protected:
 
   // a vector of cache arrays
   // set-associative: one CacheArrayNorm objects
-  // with VC: two CacheArrayNorm objects (one fully associative)
+  // with VC: two CacheArrayNorm objects (one fully associative, see CacheVictim)
+  // compressed: one CacheArrayNorm object with over-provisioned tags (see CacheCompressed)
   // skewed: partition number of CacheArrayNorm objects (each as a single cache array)
-  // MIRAGE: parition number of CacheArrayNorm (meta only) with one separate CacheArrayNorm for storing data (in derived class)
+  // sparse: CacheArraySparse objects in place of CacheArrayNorm (allocated on first touch)
+  // MIRAGE: parition number of CacheArrayNorm (meta only) with a separate data store (in derived class, see CacheMirage)
   std::vector<CacheArrayBase *> arrays;
 
   // monitor related
   std::set<MonitorBase *> monitors;
 
+  bool fast;                            // fast-forward: no delay estimation, monitoring or coherence messages
+
+#ifdef CM_PROFILE
+  CMProfileEntry *profile;              // self-profiling counters of this cache
+#endif
+
 public:
-  CacheBase(std::string name) : id(UniqueID::new_id()), name(name) {}
+  CacheBase(std::string name) : id(UniqueID::new_id()), name(name), fast(false) {
+#ifdef CM_PROFILE
+    profile = CMProfiler::entry(name);
+#endif
+  }
 
   virtual ~CacheBase() { for(auto a: arrays) delete a; }
 
@@ -168,13 +469,36 @@ public:
                    uint32_t *s, uint32_t *w
                    ) = 0;
 
-  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w) = 0;
+  // part: the partition of the requester (its coherence id), only used by way-partitioned caches
+  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w, uint32_t part = 0) = 0;
+  // an extra block to be evicted for the block replaced by the last replace() (caches with variable-size blocks),
+  // the coherence ports evict extra blocks until false is returned
+  virtual bool replace_extra(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w) { return false; }
+
+  // way partitioning (CAT-style), blocks requested by partition part are only filled in the ways of mask
+  // (all ways if mask is 0), return false if not supported by the cache or mask is out of range
+  virtual bool set_way_mask(uint32_t part, uint64_t mask) { return false; }
+  // number of valid blocks filled by partition part (tracked once a way mask is set)
+  virtual uint64_t get_partition_occupancy(uint32_t part) const { return 0; }
+
+  // non-intrusive residency query of n addresses, leaving replacer, delay and monitors untouched
+  virtual void query_batch(const uint64_t *addr, size_t n, CMResidency *rv) {
+    for(size_t i=0; i<n; i++) {
+      rv[i].cache = 0;
+      rv[i].level = hit(addr[i], &rv[i].ai, &rv[i].s, &rv[i].w) ? 0 : -1;
+    }
+  }
 
   // hook interface for replacer state update, Monitor and delay estimation
-  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay) = 0;
-  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay) = 0;
+  //   part: the partition of the requester as in replace()
+  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) = 0;
+  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) = 0;
   virtual void hook_invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool writeback, uint64_t *delay) = 0;
   virtual void hook_probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback, uint64_t *delay) = 0;
+  // hook interface for a miss served without allocating a block (exclusive caches, Monitor and delay estimation only)
+  virtual void hook_bypass(uint64_t addr, uint64_t *delay) = 0;
+  // hook interface for coherence messages sent by this cache (Monitor only), dst: id of the receiver
+  virtual void hook_message(uint64_t addr, uint32_t type, uint32_t dst) = 0;
 
   virtual CMMetadataBase *access(uint32_t ai, uint32_t s, uint32_t w) = 0;
   virtual CMDataBase *get_data(uint32_t ai, uint32_t s, uint32_t w) = 0;
@@ -190,14 +514,40 @@ public:
 
   // support run-time assign/reassign mointors
   void detach_monitor() { monitors.clear(); }
+
+  uint32_t get_id() const { return id; }
+
+  // checkpoint the cache arrays (derived caches add their indexer and replacer states)
+  virtual void save(CheckpointWriter &ckpt) const {
+    ckpt.put<uint32_t>(arrays.size());
+    for(auto a:arrays) a->save(ckpt);
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!ckpt.expect<uint32_t>(arrays.size(), "number of cache arrays")) return false;
+    for(auto a:arrays) if(!a->restore(ckpt)) return false;
+    return true;
+  }
+
+  // fast-forward (functional warm-up) mode, skipping delay estimation, monitors and message reports
+  //   (except occupancy changes of partitions, which are states)
+  //   Tags, coherence, replacer states and data evolve as in detailed mode, so the hierarchy stays
+  //   functionally correct (data written in fast-forward included) when switched back.
+  //   It keeps warm-up out of delays and statistics but is not a faster path: the tag search,
+  //   coherence and data movement it retains dominate an access, so it runs at about detailed speed.
+  void set_fast_forward(bool enable) { fast = enable; }
+  bool is_fast_forward() const { return fast; }
+#ifdef CM_PROFILE
+  CMProfileEntry *get_profile() const { return profile; }
+#endif
 };
 
 // Skewed Cache
 // IW: index width, NW: number of ways, P: number of partitions
 // MT: metadata type, DT: data type (void if not in use)
 // IDX: indexer type, RPC: replacer type
-// EnMon: whether to enable monitoring
-template<int IW, int NW, int P, typename MT, typename DT, typename IDX, typename RPC, typename DLY, bool EnMon,
+// EnMon: whether to enable monitoring, EnSparse: whether to allocate sets on first touch (CacheArraySparse)
+template<int IW, int NW, int P, typename MT, typename DT, typename IDX, typename RPC, typename DLY, bool EnMon, bool EnSparse = false,
          typename = typename std::enable_if<std::is_base_of<CMMetadataBase, MT>::value>::type,  // MT <- CMMetadataBase
          typename = typename std::enable_if<std::is_base_of<CMDataBase, DT>::value || std::is_void<DT>::value>::type, // DT <- CMDataBase or void
          typename = typename std::enable_if<std::is_base_of<IndexFuncBase, IDX>::value>::type,  // IDX <- IndexFuncBase
@@ -210,12 +560,61 @@ protected:
   RPC replacer[P]; // replacer
   DLY *timer;      // delay estimator
 
+  // way partitioning, empty unless a way mask is set
+  std::vector<uint64_t> way_mask;  // allowed ways of each partition (0 for all ways)
+  std::vector<uint16_t> owner;     // partition+1 of each block, 0 if not owned
+  std::vector<uint64_t> occupancy; // number of owned blocks of each partition
+  uint32_t fill_idx, fill_part;    // the block being filled and its partition
+
+  typedef typename std::conditional<EnSparse, CacheArraySparse<IW,NW,MT,DT>, CacheArrayNorm<IW,NW,MT,DT> >::type ArrayT;
+
+  ArrayT *array(uint32_t ai) const { return static_cast<ArrayT *>(this->arrays[ai]); }
+
+  uint32_t index(uint64_t addr, uint32_t ai) {
+    CM_PROFILE_SCOPE(this->profile, INDEX);
+    return indexer.index(addr, ai);
+  }
+
+  void report_delay(uint64_t cycles) {
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      for(auto m:this->monitors) m->delay(cycles);
+    }
+  }
+
+  // occupancy is a state rather than an event, reported in fast-forward as well to keep monitors in sync
+  void report_occupancy(uint32_t part, int64_t delta) {
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      for(auto m:this->monitors) m->occupancy(part, delta);
+    }
+  }
+
+  // assign the block filled in way w of set s to the requesting partition
+  void partition_fill(uint32_t ai, uint32_t s, uint32_t w) {
+    auto idx = (ai << IW | s) * NW + w;
+    if(idx != fill_idx) return;
+    fill_idx = -1;
+    partition_release(idx);
+    owner[idx] = fill_part + 1;
+    occupancy[fill_part]++;
+    report_occupancy(fill_part, 1);
+  }
+
+  void partition_release(uint32_t idx) {
+    if(!owner[idx]) return;
+    auto part = owner[idx] - 1;
+    owner[idx] = 0;
+    occupancy[part]--;
+    report_occupancy(part, -1);
+  }
+
 public:
   CacheSkewed(std::string name = "")
     : CacheBase(name)
   {
     arrays.resize(P);
-    for(auto &a:arrays) a = new CacheArrayNorm<IW,NW,MT,DT>();
+    for(auto &a:arrays) a = new ArrayT();
     if constexpr (!std::is_void<DLY>::value) timer = new DLY();
   }
 
@@ -224,45 +623,184 @@ public:
   }
 
   virtual bool hit(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w ) {
+    CM_PROFILE_SCOPE(this->profile, HIT);
     for(*ai=0; *ai<P; (*ai)++) {
-      *s = indexer.index(addr, *ai);
-      for(*w=0; *w<NW; (*w)++)
-        if(access(*ai, *s, *w)->match(addr)) return true;
+      *s = index(addr, *ai);
+      if(array(*ai)->lookup(addr, *s, w)) return true;
     }
     return false;
   }
 
-  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w) {
+  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w, uint32_t part = 0) {
+    CM_PROFILE_SCOPE(this->profile, REPLACE);
     if constexpr (P==1) *ai = 0;
     else                *ai = (cm_get_random_uint32() % P);
-    *s = indexer.index(addr, *ai);
-    replacer[*ai].replace(*s, w);
+    *s = index(addr, *ai);
+    CM_PROFILE_SCOPE(this->profile, REPLACER);
+    if(way_mask.empty()) replacer[*ai].replace(*s, w);
+    else {
+      auto mask = part < way_mask.size() ? way_mask[part] : 0;
+      if(mask) replacer[*ai].replace_masked(*s, w, mask);
+      else     replacer[*ai].replace(*s, w);
+      fill_idx = (*ai << IW | *s) * NW + *w;
+      fill_part = part;
+    }
+  }
+
+  virtual bool set_way_mask(uint32_t part, uint64_t mask) {
+    constexpr uint64_t all = NW >= 64 ? ~0ull : (1ull << NW) - 1;
+    if(mask & ~all || part >= 0xffff) {
+      std::cerr << "[Error] way mask 0x" << std::hex << mask << std::dec << " of partition " << part << " is out of range for " << NW << " ways!" << std::endl;
+      return false;
+    }
+    if(owner.empty()) { // start tracking occupancy, blocks filled before are not owned
+      owner.resize(P * NW << IW, 0);
+      fill_idx = -1;
+    }
+    if(part >= way_mask.size()) {
+      way_mask.resize(part + 1, 0);
+      occupancy.resize(part + 1, 0);
+    }
+    way_mask[part] = mask;
+    return true;
   }
 
-  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay) {
-    replacer[ai].access(s, w);
-    if(EnMon) for(auto m:this->monitors) m->read(addr, ai, s, w, hit);
-    if constexpr (!std::is_void<DLY>::value) timer->read(addr, ai, s, w, hit, delay);
+  virtual uint64_t get_partition_occupancy(uint32_t part) const {
+    return part < occupancy.size() ? occupancy[part] : 0;
   }
 
-  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay) {
-    replacer[ai].access(s, w);
-    if constexpr (EnMon) for(auto m:this->monitors) m->write(addr, ai, s, w, hit);
-    if constexpr (!std::is_void<DLY>::value) timer->write(addr, ai, s, w, hit, delay);
+  // resolve and prefetch the sets of a group of addresses before matching their tags
+  virtual void query_batch(const uint64_t *addr, size_t n, CMResidency *rv) {
+    constexpr size_t G = 16;
+    uint32_t set[G][P];
+    for(size_t b=0; b<n; b+=G) {
+      size_t m = std::min(G, n-b);
+      for(size_t i=0; i<m; i++)
+        for(int ai=0; ai<P; ai++) {
+          set[i][ai] = indexer.IDX::index(addr[b+i], ai);
+          array(ai)->prefetch(set[i][ai]);
+        }
+      for(size_t i=0; i<m; i++) {
+        auto &r = rv[b+i];
+        r.level = -1; r.cache = 0;
+        for(int ai=0; ai<P; ai++)
+          if(array(ai)->lookup(addr[b+i], set[i][ai], &r.w)) {
+            r.level = 0; r.ai = ai; r.s = set[i][ai];
+            break;
+          }
+      }
+    }
+  }
+
+  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    {
+      CM_PROFILE_SCOPE(this->profile, REPLACER);
+      replacer[ai].access(s, w);
+    }
+    if(!hit && !owner.empty()) partition_fill(ai, s, w);
+    if(this->fast) return;
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      for(auto m:this->monitors) m->read(addr, ai, s, w, hit);
+    }
+    if constexpr (!std::is_void<DLY>::value) if(delay) {
+      uint64_t d = *delay;
+      timer->read(addr, ai, s, w, hit, delay);
+      report_delay(*delay - d);
+    }
+  }
+
+  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    {
+      CM_PROFILE_SCOPE(this->profile, REPLACER);
+      replacer[ai].access(s, w);
+    }
+    if(!hit && !owner.empty()) partition_fill(ai, s, w);
+    if(this->fast) return;
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      for(auto m:this->monitors) m->write(addr, ai, s, w, hit);
+    }
+    if constexpr (!std::is_void<DLY>::value) if(delay) {
+      uint64_t d = *delay;
+      timer->write(addr, ai, s, w, hit, delay);
+      report_delay(*delay - d);
+    }
   }
 
   virtual void hook_invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool writeback, uint64_t *delay) {
-    replacer[ai].invalid(s, w);
-    if constexpr (EnMon) for(auto m:this->monitors) m->invalid(addr, ai, s, w);
-    if constexpr (!std::is_void<DLY>::value) timer->invalid(addr, ai, s, w, writeback, delay);
+    {
+      CM_PROFILE_SCOPE(this->profile, REPLACER);
+      replacer[ai].invalid(s, w);
+    }
+    if(!owner.empty()) partition_release((ai << IW | s) * NW + w);
+    if(this->fast) return;
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      for(auto m:this->monitors) m->invalid(addr, ai, s, w);
+    }
+    if constexpr (!std::is_void<DLY>::value) if(delay) {
+      uint64_t d = *delay;
+      timer->invalid(addr, ai, s, w, writeback, delay);
+      report_delay(*delay - d);
+    }
   }
 
   virtual void hook_probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback, uint64_t *delay) {
     if(evict) { // currently, we only care when the probe evict a block
+      CM_PROFILE_SCOPE(this->profile, REPLACER);
       replacer[ai].invalid(s, w);
-      if constexpr (EnMon) for(auto m:this->monitors) m->invalid(addr, ai, s, w);
+      if(!owner.empty()) partition_release((ai << IW | s) * NW + w);
+    }
+    if(this->fast) return;
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      if(evict) for(auto m:this->monitors) m->invalid(addr, ai, s, w);
+      for(auto m:this->monitors) m->probe(addr, ai, s, w, evict, writeback);
+    }
+    if constexpr (!std::is_void<DLY>::value) if(delay) {
+      uint64_t d = *delay;
+      timer->probe(addr, ai, s, w, writeback, delay);
+      report_delay(*delay - d);
+    }
+  }
+
+  // reported as a read miss of the first partition with an invalid way (-1)
+  virtual void hook_bypass(uint64_t addr, uint64_t *delay) {
+    if(this->fast) return;
+    uint32_t s = index(addr, 0);
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      for(auto m:this->monitors) m->read(addr, 0, s, -1, false);
+    }
+    if constexpr (!std::is_void<DLY>::value) if(delay) {
+      uint64_t d = *delay;
+      timer->read(addr, 0, s, -1, false, delay);
+      report_delay(*delay - d);
+    }
+  }
+
+  virtual void hook_message(uint64_t addr, uint32_t type, uint32_t dst) {
+    if constexpr (EnMon) if(!this->fast) for(auto m:this->monitors) m->message(addr, type, this->id, dst);
+  }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    CacheBase::save(ckpt);
+    indexer.save(ckpt);
+    for(int i=0; i<P; i++) replacer[i].save(ckpt);
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!CacheBase::restore(ckpt) || !indexer.restore(ckpt)) return false;
+    for(int i=0; i<P; i++) if(!replacer[i].restore(ckpt)) return false;
+    // ownership is not checkpointed, restored blocks are not owned by any partition
+    std::fill(owner.begin(), owner.end(), 0);
+    for(uint32_t p=0; p<occupancy.size(); p++) if(occupancy[p]) {
+      report_occupancy(p, -(int64_t)occupancy[p]);
+      occupancy[p] = 0;
     }
-    if constexpr (!std::is_void<DLY>::value) timer->probe(addr, ai, s, w, writeback, delay);
+    fill_idx = -1;
+    return true;
   }
 
   virtual CMMetadataBase *access(uint32_t ai, uint32_t s, uint32_t w){
@@ -274,7 +812,7 @@ public:
 };
 
 // Normal set-associative cache
-template<int IW, int NW, typename MT, typename DT, typename IDX, typename RPC, typename DLY, bool EnMon>
-using CacheNorm = CacheSkewed<IW, NW, 1, MT, DT, IDX, RPC, DLY, EnMon>;
+template<int IW, int NW, typename MT, typename DT, typename IDX, typename RPC, typename DLY, bool EnMon, bool EnSparse = false>
+using CacheNorm = CacheSkewed<IW, NW, 1, MT, DT, IDX, RPC, DLY, EnMon, EnSparse>;
 
 #endif
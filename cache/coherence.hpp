@@ -1,6 +1,7 @@
 #ifndef CM_CACHE_COHERENCE_HPP
 #define CM_CACHE_COHERENCE_HPP
 
+#include <cassert>
 #include <type_traits>
 #include "cache/cache.hpp"
 
@@ -25,14 +26,19 @@ protected:
   CohMasterBase *coh; // hook up with the coherence hub
   uint32_t coh_id; // the identifier used in locating this cache client by the coherence mster
 public:
-  OuterCohPortBase() {}
+  OuterCohPortBase() : cache(nullptr) {}
   virtual ~OuterCohPortBase() {}
 
+  uint32_t get_id() const { return cache ? cache->get_id() : 0; } // id of the cache behind this port
+
   virtual void connect(CohMasterBase *h, uint32_t id) {coh = h; coh_id = id;}
 
   virtual void acquire_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) = 0;
   virtual void writeback_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) = 0;
+  virtual bool evict_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint64_t *delay) = 0; // release a replaced block, return whether data is sent
   virtual void probe_resp(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) {} // may not implement if not supported
+  // fetch the words requested by data (see DataSectored) of a block already held, no change of coherence state
+  virtual void fetch_req(uint64_t addr, CMDataBase *data, uint64_t *delay) { assert(nullptr == "Error: fetch_req() is not supported by this outer port!"); }
 
   friend CoherentCacheBase; // deferred assignment for cache
 };
@@ -47,14 +53,22 @@ protected:
   OuterCohPortBase *outer; // outer port for writeback when replace
   std::vector<CohClientBase *> coh; // hook up with the inner caches, indexed by vector index
 public:
-  InnerCohPortBase() {}
+  InnerCohPortBase() : cache(nullptr) {}
   virtual ~InnerCohPortBase() {}
 
+  uint32_t get_id() const { return cache ? cache->get_id() : 0; } // id of the cache behind this port, 0 for memory
+  virtual uint32_t get_id(uint64_t addr) { return get_id(); }     // id of the cache serving addr (a slice behind a dispatcher)
+
   virtual uint32_t connect(CohClientBase *c) { coh.push_back(c); return coh.size() - 1;}
 
   virtual void acquire_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) = 0;
   virtual void writeback_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) = 0;
   virtual void probe_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) {} // may not implement if not supported
+  virtual void fetch_resp(uint64_t addr, CMDataBase *data, uint64_t *delay) { assert(nullptr == "Error: fetch_resp() is not supported by this inner port!"); }
+
+  // checkpoint the state kept by the port itself (e.g. a snoop filter), none by default
+  virtual void save(CheckpointWriter &ckpt) const {}
+  virtual bool restore(CheckpointReader &ckpt) { return true; }
 
   friend CoherentCacheBase; // deferred assignment for cache
 };
@@ -76,6 +90,7 @@ private:
   virtual uint32_t connect(CohClientBase *c) { return 0;}
   virtual void acquire_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {}
   virtual void writeback_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {}
+  virtual void fetch_resp(uint64_t addr, CMDataBase *data, uint64_t *delay) {}
 };
 
 
@@ -110,9 +125,46 @@ public:
   bool attach_monitor(MonitorBase *m) { return cache->attach_monitor(m); }
   // support run-time assign/reassign mointors
   void detach_monitor() { cache->detach_monitor(); }
+
+  // residency of n addresses in this cache
+  void query_batch(const uint64_t *addr, size_t n, CMResidency *rv) { cache->query_batch(addr, n, rv); }
+
+  // switch between fast-forward (functional warm-up) and detailed simulation
+  void set_fast_forward(bool enable) { cache->set_fast_forward(enable); }
+
+  // way partitioning, part is the coherence id of the requesting inner cache (reconfigurable at run time)
+  bool set_way_mask(uint32_t part, uint64_t mask) { return cache->set_way_mask(part, mask); }
+  uint64_t get_partition_occupancy(uint32_t part) const { return cache->get_partition_occupancy(part); }
+
+  // checkpoint the cache state, restore into a cache of the same name and geometry
+  void save(CheckpointWriter &ckpt) const {
+    ckpt.put_string(name);
+    cache->save(ckpt);
+    if(inner) inner->save(ckpt);
+  }
+  bool restore(CheckpointReader &ckpt) {
+    return ckpt.expect_string(name, "cache") && cache->restore(ckpt) && (!inner || inner->restore(ckpt));
+  }
 };
 
 
+// merge the residency of a group of caches of a hierarchy level into rv,
+// addresses already found in an inner level (or an earlier group) are kept
+//   base: index of the first cache of this group in the level (several groups may share a level)
+template<typename CT>
+inline void cm_query_level(const std::vector<CT *> &caches, int32_t level, const uint64_t *addr, size_t n, CMResidency *rv, uint32_t base = 0) {
+  std::vector<CMResidency> r(n);
+  for(uint32_t c=0; c<caches.size(); c++) {
+    caches[c]->query_batch(addr, n, r.data());
+    for(size_t i=0; i<n; i++)
+      if(rv[i].level < 0 && r[i].level >= 0) {
+        rv[i] = r[i];
+        rv[i].level = level;
+        rv[i].cache = base + c;
+      }
+  }
+}
+
 // Normal coherent cache
 template<typename CacheT, typename OuterT, typename InnerT,
          typename = typename std::enable_if<std::is_base_of<CacheBase, CacheT>::value>::type,  // CacheT <- CacheBase
@@ -121,7 +173,7 @@ template<typename CacheT, typename OuterT, typename InnerT,
 class CoherentCacheNorm : public CoherentCacheBase
 {
 public:
-  CoherentCacheNorm(std::string name = "") : CoherentCacheBase(new CacheT(), new OuterT(), new InnerT(), name) {}
+  CoherentCacheNorm(std::string name = "") : CoherentCacheBase(new CacheT(name), new OuterT(), new InnerT(), name) {}
   virtual ~CoherentCacheNorm() {}
 };
 
@@ -0,0 +1,252 @@
+#ifndef CM_CACHE_COMPRESS_HPP
+#define CM_CACHE_COMPRESS_HPP
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include <type_traits>
+
+#include "cache/cache.hpp"
+
+/////////////////////////////////
+// Base class of compressibility functions
+//   size() returns the compressed size (in bytes) of a block of nword 64b words (at most 16),
+//   the kernels are branch-free loops over fixed-size arrays to be vectorized by the compiler
+class CompressFuncBase
+{
+public:
+  virtual ~CompressFuncBase() {}
+  virtual uint32_t size(const uint64_t *block, uint32_t nword) const = 0;
+};
+
+// no compression
+class CompressNone : public CompressFuncBase
+{
+public:
+  virtual uint32_t size(const uint64_t *block, uint32_t nword) const { return nword * 8; }
+};
+
+/////////////////////////////////
+// Base-Delta-Immediate compression (Pekhimenko et al., PACT 2012)
+//   each element is a delta to a base (the first element not fitting as an immediate) or an immediate (delta to 0),
+//   the smallest of zero (1B), repeated (8B), and base B delta D encodings (B + n*D) is chosen
+class CompressBDI : public CompressFuncBase
+{
+  // all elements of type T in a block of NB bytes fit in a signed delta of type D
+  template<uint32_t NB, typename T, typename D>
+  static bool fit(const uint64_t *block) {
+    typedef typename std::make_signed<T>::type S;
+    constexpr uint32_t n = NB / sizeof(T);
+    T v[n];
+    memcpy(v, block, NB);
+    T base = 0;
+    for(uint32_t i=0; i<n; i++) if((S)v[i] != (S)(D)v[i]) { base = v[i]; break; }
+    uint32_t bad = 0;
+    for(uint32_t i=0; i<n; i++) {
+      S x = (S)v[i], d = (S)(v[i] - base);
+      bad |= (x != (S)(D)x) & (d != (S)(D)d);
+    }
+    return !bad;
+  }
+
+  template<uint32_t NB, typename T, typename D>
+  static uint32_t encode(const uint64_t *block, uint32_t best) {
+    constexpr uint32_t rv = sizeof(T) + NB / sizeof(T) * sizeof(D);
+    return rv < best && fit<NB, T, D>(block) ? rv : best;
+  }
+
+  template<uint32_t NB>
+  static uint32_t size(const uint64_t *block) {
+    constexpr uint32_t nword = NB / 8;
+    uint64_t diff = 0, all = 0;
+    for(uint32_t i=0; i<nword; i++) { diff |= block[i] ^ block[0]; all |= block[i]; }
+    if(!all) return 1;
+    if(!diff) return 8;
+    uint32_t best = NB;
+    best = encode<NB, uint64_t, int8_t >(block, best);
+    best = encode<NB, uint32_t, int8_t >(block, best);
+    best = encode<NB, uint64_t, int16_t>(block, best);
+    best = encode<NB, uint16_t, int8_t >(block, best);
+    best = encode<NB, uint32_t, int16_t>(block, best);
+    best = encode<NB, uint64_t, int32_t>(block, best);
+    return best;
+  }
+
+public:
+  virtual uint32_t size(const uint64_t *block, uint32_t nword) const {
+    switch(nword) {
+    case 4:  return size<32>(block);
+    case 8:  return size<64>(block);
+    case 16: return size<128>(block);
+    default: assert(0 == "CompressBDI supports blocks of 32, 64 or 128 bytes"); return nword * 8;
+    }
+  }
+};
+
+/////////////////////////////////
+// Frequent Pattern Compression (Alameldeen and Wood, 2004)
+//   each 32b word is coded with a 3b prefix and 0 (in a zero run of up to 8 words), 4, 8 or 16 (sign-extended),
+//   16 (zero-padded halfword or two sign-extended bytes), 8 (repeated bytes) or 32 bits
+class CompressFPC : public CompressFuncBase
+{
+public:
+  virtual uint32_t size(const uint64_t *block, uint32_t nword) const {
+    assert(nword <= 16);
+    int32_t v[32];
+    uint32_t n = nword * 2, bits = 0, zero_prev = 0;
+    memcpy(v, block, nword * 8);
+    for(uint32_t i=0; i<n; i++) {
+      int32_t x = v[i];
+      uint32_t zero = x == 0;
+      uint32_t se4  = x == ((int32_t)((uint32_t)x << 28) >> 28);
+      uint32_t se8  = x == (int8_t)x;
+      uint32_t se16 = x == (int16_t)x;
+      uint32_t pad  = (x & 0xffff) == 0;
+      uint32_t half = (x >> 16) == (int8_t)(x >> 16) && (int16_t)x == (int8_t)x;
+      uint32_t rep  = (uint32_t)x == ((uint32_t)x & 0xff) * 0x01010101u;
+      uint32_t w = se4 ? 4 : (se8 | rep) ? 8 : (se16 | pad | half) ? 16 : 32;
+      // a zero word starts a run (3b run length) unless following a zero word in the same run of 8
+      uint32_t run = zero & (zero_prev & ((i & 7) != 0));
+      bits += zero ? (run ? 0 : 6) : 3 + w;
+      zero_prev = zero;
+    }
+    return (bits + 7) / 8;
+  }
+};
+
+// 64b words of the (unsectored) data blocks of a compressed cache, 64B blocks when no data is kept
+template<typename DT, typename = void>
+struct CompressBlock {
+  constexpr static uint32_t nword = 8;
+  constexpr static bool valid = std::is_void<DT>::value;
+};
+
+template<typename DT>
+struct CompressBlock<DT, typename std::enable_if<!std::is_void<DT>::value>::type> {
+  constexpr static uint32_t nword = DT::nword;
+  constexpr static bool valid = std::is_base_of<DataBlock<DT::nword * 8>, DT>::value && !is_data_sectored<DT>;
+};
+
+/////////////////////////////////
+// Compressed cache
+// IW: index width, NW: number of physical ways (data budget of NW uncompressed blocks per set)
+// EW: number of extra (over-provisioned) tags per set, MT: metadata type, DT: data type (a DataBlock, void if not in use)
+// IDX: indexer type, RPC: replacer type (of NW+EW ways), CMP: compressibility function
+// EnMon: whether to enable monitoring
+//   The tag array of each set has NW+EW ways and the data array of a set is NW blocks divided into segments
+//   of 8B. A block takes the segments of its compressed size, computed from its data when filled or written
+//   back, so a set holds more than NW blocks while the segments fit in the budget.
+//   As the size of a missing block is unknown, the coherence ports ask for extra victims (replace_extra())
+//   until an uncompressed block fits. Blocks growing on a writeback may exceed the budget of their set
+//   until the next fill of the set.
+//   Data are stored uncompressed (a data block per tag) as only the capacity is modeled.
+template<int IW, int NW, int EW, typename MT, typename DT, typename IDX, typename RPC, typename CMP, typename DLY, bool EnMon,
+         typename = typename std::enable_if<std::is_base_of<CompressFuncBase, CMP>::value>::type> // CMP <- CompressFuncBase
+class CacheCompressed : public CacheSkewed<IW, NW+EW, 1, MT, DT, IDX, RPC, DLY, EnMon>
+{
+  typedef CacheSkewed<IW, NW+EW, 1, MT, DT, IDX, RPC, DLY, EnMon> CacheT;
+  constexpr static uint32_t TW = NW + EW;           // tag ways per set
+  constexpr static uint32_t nset = 1ul << IW;
+  constexpr static uint32_t BS = CompressBlock<DT>::nword; // segments of an uncompressed block
+  constexpr static uint32_t budget = NW * BS;       // segments of a set
+  static_assert(TW <= 64, "CacheCompressed supports up to 64 tags per set");
+  static_assert(CompressBlock<DT>::valid, "the data type of CacheCompressed must be a DataBlock or void");
+
+protected:
+  CMP compressor;
+  std::vector<uint8_t>  seg;   // segments of each tag, 0 if invalid
+  std::vector<uint16_t> used;  // segments used by each set
+  uint32_t fill_s, fill_w;     // the tag being filled
+  uint64_t cnt_blocks, cnt_segments, cnt_extra;
+
+  void resize(uint32_t s, uint32_t w, uint32_t n) {
+    auto &b = seg[s*TW + w];
+    int32_t d = (int32_t)n - b;
+    cnt_blocks += (int32_t)(n != 0) - (b != 0);
+    cnt_segments += d;
+    used[s] += d;
+    b = n;
+  }
+
+  // segments of the block in way w of set s
+  uint32_t segments(uint32_t s, uint32_t w) {
+    if constexpr (std::is_void<DT>::value) return BS;
+    else {
+      auto block = static_cast<DT *>(this->array(0)->get_data(s, w))->words();
+      return (compressor.CMP::size(block, BS) + 7) / 8;
+    }
+  }
+
+public:
+  CacheCompressed(std::string name = "")
+    : CacheT(name), seg(nset * TW, 0), used(nset, 0), fill_s(0), fill_w(0), cnt_blocks(0), cnt_segments(0), cnt_extra(0) {}
+
+  virtual ~CacheCompressed() {}
+
+  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w, uint32_t part = 0) {
+    CacheT::replace(addr, ai, s, w, part);
+    fill_s = *s; fill_w = *w;
+  }
+
+  // evict the LRU blocks other than the one being filled until an uncompressed block fits
+  virtual bool replace_extra(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w) {
+    if(used[fill_s] + BS - seg[fill_s*TW + fill_w] <= budget) return false;
+    uint64_t mask = 0;
+    for(uint32_t i=0; i<TW; i++) if(seg[fill_s*TW + i] && i != fill_w) mask |= 1ull << i;
+    if(!mask) return false;
+    CM_PROFILE_SCOPE(this->profile, REPLACER);
+    this->replacer[0].replace_masked(fill_s, w, mask);
+    *ai = 0; *s = fill_s;
+    cnt_extra++;
+    return true;
+  }
+
+  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    if(!hit) resize(s, w, segments(s, w));
+    CacheT::hook_read(addr, ai, s, w, hit, delay, part);
+  }
+
+  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    resize(s, w, segments(s, w));
+    CacheT::hook_write(addr, ai, s, w, hit, delay, part);
+  }
+
+  virtual void hook_invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool writeback, uint64_t *delay) {
+    resize(s, w, 0);
+    CacheT::hook_invalid(addr, ai, s, w, writeback, delay);
+  }
+
+  virtual void hook_probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback, uint64_t *delay) {
+    if(evict) resize(s, w, 0);
+    CacheT::hook_probe(addr, ai, s, w, evict, writeback, delay);
+  }
+
+  // capacity statistics
+  uint64_t get_valid_blocks() const { return cnt_blocks; }
+  uint64_t get_used_segments() const { return cnt_segments; }
+  uint64_t get_extra_evictions() const { return cnt_extra; }
+  // valid blocks relative to the physical capacity (NW blocks per set)
+  double get_effective_capacity() const { return (double)cnt_blocks / (nset * NW); }
+  // uncompressed size of the valid blocks relative to their compressed size
+  double get_compression_ratio() const { return cnt_segments ? (double)cnt_blocks * BS / cnt_segments : 1.0; }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    CacheT::save(ckpt);
+    ckpt.write(seg.data(), seg.size());
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!CacheT::restore(ckpt)) return false;
+    ckpt.read(seg.data(), seg.size());
+    std::fill(used.begin(), used.end(), 0);
+    cnt_blocks = 0; cnt_segments = 0;
+    for(uint32_t i=0; i<nset * TW; i++) {
+      used[i / TW] += seg[i];
+      cnt_blocks += seg[i] != 0;
+      cnt_segments += seg[i];
+    }
+    return ckpt.good();
+  }
+};
+
+#endif
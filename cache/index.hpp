@@ -4,6 +4,7 @@
 #include<vector>
 
 #include "util/random.hpp"
+#include "util/checkpoint.hpp"
 
 /////////////////////////////////
 // Base class
@@ -15,6 +16,10 @@ public:
   IndexFuncBase(uint32_t mask) : mask(mask) {}
   virtual ~IndexFuncBase() {}
   virtual uint32_t index(uint64_t addr, int partition) = 0;
+
+  // checkpoint the seeds of keyed index functions
+  virtual void save(CheckpointWriter &ckpt) const {}
+  virtual bool restore(CheckpointReader &ckpt) { return true; }
 };
 
 
@@ -51,6 +56,17 @@ public:
   void seed(std::vector<uint64_t>& seeds) {
     for(int i=0; i<P; i++) hashers[i].seed(seeds[i]);
   }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    ckpt.put<uint32_t>(P);
+    for(int i=0; i<P; i++) ckpt.put<uint64_t>(hashers[i].get_seed());
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!ckpt.expect<uint32_t>(P, "number of index partitions")) return false;
+    for(int i=0; i<P; i++) hashers[i].seed(ckpt.get<uint64_t>());
+    return ckpt.good();
+  }
 };
 
 /////////////////////////////////
@@ -5,7 +5,10 @@
 #include <sys/mman.h>
 #include <unordered_map>
 #include <type_traits>
+#include <vector>
+#include <algorithm>
 
+// DT: data type (a DataBlock, void if not in use), DLY: delay estimator type
 template<typename DT, typename DLY,
          typename = typename std::enable_if<std::is_base_of<CMDataBase, DT>::value || std::is_void<DT>::value>::type, // DT <- CMDataBase or void
          typename = typename std::enable_if<std::is_base_of<DelayBase, DLY>::value || std::is_void<DLY>::value>::type>  // DLY <- DelayBase or void
@@ -15,15 +18,29 @@ protected:
   std::string name;
   std::unordered_map<uint64_t, char *> pages;
   DLY *timer;      // delay estimator
+#ifdef CM_PROFILE
+  CMProfileEntry *profile;
+#endif
 
   void allocate(uint64_t ppn) {
     char *page = static_cast<char *>(mmap(NULL, 4096, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0));
     assert(page != MAP_FAILED);
     pages[ppn] = page;
   }
-  
+
+  // the block of addr in memory
+  uint64_t *block(uint64_t addr) {
+    auto ppn = addr >> 12;
+    auto offset = addr & 0x0fffull & ~(uint64_t)(DT::nword * 8 - 1);
+    if(!pages.count(ppn)) allocate(ppn);
+    return reinterpret_cast<uint64_t *>(pages[ppn] + offset);
+  }
+
 public:
   SimpleMemoryModel(const std::string &n) : name(n) {
+#ifdef CM_PROFILE
+    profile = CMProfiler::entry(n);
+#endif
     if constexpr (!std::is_void<DLY>::value) timer = new DLY();
   }
   virtual ~SimpleMemoryModel() {
@@ -31,25 +48,57 @@ public:
   }
 
   virtual void acquire_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
-    if constexpr (!std::is_void<DT>::value) {
-      auto ppn = addr >> 12;
-      auto offset = addr & 0x0fffull;
-      if(!pages.count(ppn)) allocate(ppn);
-      uint64_t *mem_addr = reinterpret_cast<uint64_t *>(pages[ppn] + offset);
-      data->write(mem_addr);
-    }
-    if constexpr (!std::is_void<DLY>::value) timer->read(addr, 0, 0, 0, 0, delay);
+    CM_PROFILE_SCOPE(profile, MEMORY);
+    if constexpr (!std::is_void<DT>::value) if(data) data->write(block(addr));
+    if constexpr (!std::is_void<DLY>::value) if(delay) timer->read(addr, 0, 0, 0, 0, delay);
+  }
+
+  // read the requested sectors of a held block
+  virtual void fetch_resp(uint64_t addr, CMDataBase *data, uint64_t *delay) {
+    CM_PROFILE_SCOPE(profile, MEMORY);
+    if constexpr (!std::is_void<DT>::value) if(data) data->write(block(addr));
+    if constexpr (!std::is_void<DLY>::value) if(delay) timer->read(addr, 0, 0, 0, 0, delay);
   }
 
   virtual void writeback_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
-    if constexpr (!std::is_void<DT>::value) {
-      auto ppn = addr >> 12;
-      auto offset = addr & 0x0fffull;
-      assert(pages.count(ppn));
-      uint64_t *mem_addr = reinterpret_cast<uint64_t *>(pages[ppn] + offset);
-      for(int i=0; i<8; i++) mem_addr[i] = data->read(i);
+    CM_PROFILE_SCOPE(profile, MEMORY);
+    if constexpr (!std::is_void<DT>::value) if(data) data->read_block(block(addr));
+    if constexpr (!std::is_void<DLY>::value) if(delay) timer->write(addr, 0, 0, 0, 0, delay);
+  }
+
+  // checkpoint: the page table followed by the 4KB aligned pages
+  void save(CheckpointWriter &ckpt) const {
+    ckpt.put_string(name);
+    std::vector<uint64_t> ppns;
+    for(auto &p:pages) ppns.push_back(p.first);
+    std::sort(ppns.begin(), ppns.end());
+    ckpt.put<uint64_t>(ppns.size());
+    for(auto ppn:ppns) ckpt.put<uint64_t>(ppn);
+    ckpt.align(4096);
+    for(auto ppn:ppns) ckpt.write(pages.at(ppn), 4096);
+  }
+
+  // pages are mapped from the checkpoint copy-on-write, copied only when mapping fails
+  //   (a checkpoint is never overwritten in place by CheckpointWriter, see util/checkpoint.hpp)
+  bool restore(CheckpointReader &ckpt) {
+    if(!ckpt.expect_string(name, "memory")) return false;
+    std::vector<uint64_t> ppns(ckpt.get<uint64_t>());
+    for(auto &ppn:ppns) ppn = ckpt.get<uint64_t>();
+    if(!ckpt.good()) return false;
+    for(auto &p:pages) munmap(p.second, 4096);
+    pages.clear();
+    ckpt.align(4096);
+    for(auto ppn:ppns) {
+      char *page = static_cast<char *>(ckpt.map(4096));
+      if(!page) {
+        auto src = ckpt.peek(4096);
+        if(!src) return false;
+        allocate(ppn);
+        memcpy(pages[ppn], src, 4096);
+      } else
+        pages[ppn] = page;
     }
-    if constexpr (!std::is_void<DLY>::value) timer->write(addr, 0, 0, 0, 0, delay);
+    return ckpt.good();
   }
 
 private:
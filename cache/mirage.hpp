@@ -0,0 +1,198 @@
+#ifndef CM_CACHE_MIRAGE_HPP
+#define CM_CACHE_MIRAGE_HPP
+
+#include <cassert>
+#include <vector>
+
+#include "cache/cache.hpp"
+
+// MIRAGE cache (Saileshwar and Qureshi, USENIX Security 2021)
+// IW: index width, NW: number of data ways per skew, EW: number of extra (over-provisioned) tag ways per skew
+// P: number of skews, MT: metadata type (with a full tag as in skewed caches), DT: data type (void if not in use)
+// IDX: indexer type, RPC: replacer type (of NW+EW ways), EnMon: whether to enable monitoring
+//   arrays[0..P-1] are the skewed tag arrays (meta only) and the data store of P*NW*2^IW blocks is kept
+//   separately, linked by forward (tag -> data) and reverse (data -> tag) pointers.
+//   A block is placed in the skew whose set has fewer valid tags (load-aware, ties broken randomly)
+//   and takes a free data block, or the data block of a globally random victim if the data store is full
+//   (both O(1) by a free list and an occupied list). Only when the chosen set has no free tag, a block
+//   of the set is evicted instead (set-associative eviction, SAE).
+//   For a global eviction, replace() returns the tag of the victim to the coherence ports, which evict
+//   it and fill the new block there; the filled tag is moved to the chosen set when the fill is hooked.
+template<int IW, int NW, int EW, int P, typename MT, typename DT, typename IDX, typename RPC, typename DLY, bool EnMon>
+class CacheMirage : public CacheSkewed<IW, NW+EW, P, MT, void, IDX, RPC, DLY, EnMon>
+{
+  typedef CacheSkewed<IW, NW+EW, P, MT, void, IDX, RPC, DLY, EnMon> CacheT;
+  constexpr static uint32_t TW = NW + EW;               // tag ways per set
+  constexpr static uint32_t nset = 1ul << IW;
+  constexpr static uint32_t ntag = P * nset * TW;
+  constexpr static uint32_t ndata = P * nset * NW;
+  constexpr static uint32_t none = -1;
+
+protected:
+  std::vector<typename std::conditional<std::is_void<DT>::value, char, DT>::type> data; // data store (empty if DT is void)
+  std::vector<uint32_t> fptr;      // data block of each tag, none if invalid
+  std::vector<uint32_t> rptr;      // tag of each data block
+  std::vector<uint32_t> occupied;  // occupied data blocks
+  std::vector<uint32_t> opos;      // position of each data block in occupied
+  std::vector<uint32_t> free_list; // free data blocks
+  std::vector<uint32_t> load;      // number of valid tags of each set
+  bool pending;                    // a fill of a globally evicted tag is not hooked yet
+  uint32_t pending_tag, pending_victim;
+  uint64_t cnt_global, cnt_sae;
+
+  static uint32_t tag(uint32_t ai, uint32_t s, uint32_t w) { return (ai * nset + s) * TW + w; }
+
+  void attach(uint32_t t, uint32_t d) {
+    fptr[t] = d; rptr[d] = t;
+    load[t / TW]++;
+  }
+
+  // free the data block of an invalidated tag (unless it is being refilled)
+  void detach(uint32_t ai, uint32_t s, uint32_t w) {
+    auto t = tag(ai, s, w);
+    auto d = fptr[t];
+    if(d == none || (pending && t == pending_victim)) return;
+    fptr[t] = none;
+    load[t / TW]--;
+    auto last = occupied.back();
+    occupied[opos[d]] = last; opos[last] = opos[d];
+    occupied.pop_back();
+    free_list.push_back(d);
+  }
+
+  // move the tag filled through a globally evicted tag to the chosen set
+  void fill(uint32_t *ai, uint32_t *s, uint32_t *w) {
+    pending = false;
+    if(pending_tag == pending_victim) return;
+    uint32_t v = pending_victim, t = pending_tag;
+    MT *m = nullptr;
+    void *d = nullptr;
+    this->array(v / (nset * TW))->exchange((v / TW) % nset, v % TW, &m, &d);
+    this->array(t / (nset * TW))->exchange((t / TW) % nset, t % TW, &m, &d);
+    this->array(v / (nset * TW))->exchange((v / TW) % nset, v % TW, &m, &d);
+    auto data_block = fptr[v];
+    fptr[v] = none;
+    load[v / TW]--;
+    attach(t, data_block);
+    *ai = t / (nset * TW); *s = (t / TW) % nset; *w = t % TW;
+  }
+
+public:
+  CacheMirage(std::string name = "")
+    : CacheT(name), fptr(ntag, none), rptr(ndata, none), opos(ndata, 0), load(P * nset, 0), pending(false), cnt_global(0), cnt_sae(0)
+  {
+    if constexpr (!std::is_void<DT>::value) data.resize(ndata);
+    occupied.reserve(ndata);
+    free_list.resize(ndata);
+    for(uint32_t i=0; i<ndata; i++) free_list[i] = ndata - 1 - i;
+  }
+
+  virtual ~CacheMirage() {}
+
+  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w, uint32_t part = 0) {
+    CM_PROFILE_SCOPE(this->profile, REPLACE);
+    assert(!pending);
+    // load-aware skew selection
+    uint32_t ties = 0, min_load = TW + 1;
+    for(uint32_t i=0; i<P; i++) {
+      auto si = this->index(addr, i);
+      auto l = load[i * nset + si];
+      if(l < min_load) { min_load = l; ties = 1; *ai = i; *s = si; }
+      else if(l == min_load && cm_get_random_uint32() % (++ties) == 0) { *ai = i; *s = si; }
+    }
+
+    if(min_load == TW) { // set-associative eviction
+      cnt_sae++;
+      CM_PROFILE_SCOPE(this->profile, REPLACER);
+      this->replacer[*ai].replace(*s, w);
+      pending = true;
+      pending_tag = pending_victim = tag(*ai, *s, *w);
+      return;
+    }
+
+    for(*w=0; *w<TW; (*w)++) if(fptr[tag(*ai, *s, *w)] == none) break;
+    if(!free_list.empty()) { // take a free data block
+      auto d = free_list.back();
+      free_list.pop_back();
+      opos[d] = occupied.size();
+      occupied.push_back(d);
+      attach(tag(*ai, *s, *w), d);
+    } else { // global random eviction, the victim tag is evicted and refilled by the coherence ports
+      cnt_global++;
+      pending = true;
+      pending_tag = tag(*ai, *s, *w);
+      pending_victim = rptr[occupied[cm_get_random_uint32() % occupied.size()]];
+      *ai = pending_victim / (nset * TW); *s = (pending_victim / TW) % nset; *w = pending_victim % TW;
+    }
+  }
+
+  // no way partitioning as data blocks are not bound to ways
+  virtual bool set_way_mask(uint32_t part, uint64_t mask) {
+    std::cerr << "[Error] CacheMirage does not support way partitioning!" << std::endl;
+    return false;
+  }
+
+  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    if(pending && tag(ai, s, w) == pending_victim) fill(&ai, &s, &w);
+    CacheT::hook_read(addr, ai, s, w, hit, delay, part);
+  }
+
+  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    if(pending && tag(ai, s, w) == pending_victim) fill(&ai, &s, &w);
+    CacheT::hook_write(addr, ai, s, w, hit, delay, part);
+  }
+
+  virtual void hook_invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool writeback, uint64_t *delay) {
+    CacheT::hook_invalid(addr, ai, s, w, writeback, delay);
+    detach(ai, s, w);
+  }
+
+  virtual void hook_probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback, uint64_t *delay) {
+    CacheT::hook_probe(addr, ai, s, w, evict, writeback, delay);
+    if(evict) detach(ai, s, w);
+  }
+
+  virtual CMDataBase *get_data(uint32_t ai, uint32_t s, uint32_t w) {
+    if constexpr (std::is_void<DT>::value) return nullptr;
+    else {
+      auto d = fptr[tag(ai, s, w)];
+      return d == none ? nullptr : &data[d];
+    }
+  }
+
+  uint64_t get_global_evictions() const { return cnt_global; }
+  uint64_t get_sae() const { return cnt_sae; }
+  uint32_t get_occupancy() const { return occupied.size(); }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    assert(!pending);
+    CacheT::save(ckpt);
+    ckpt.put<uint32_t>(ndata);
+    ckpt.write(fptr.data(), ntag * sizeof(uint32_t));
+    ckpt.write(rptr.data(), ndata * sizeof(uint32_t));
+    ckpt.put<uint32_t>(occupied.size());
+    ckpt.write(occupied.data(), occupied.size() * sizeof(uint32_t));
+    ckpt.write(free_list.data(), free_list.size() * sizeof(uint32_t));
+    if constexpr (!std::is_void<DT>::value) for(auto &d:data) d.save(ckpt);
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!CacheT::restore(ckpt) || !ckpt.expect<uint32_t>(ndata, "number of data blocks")) return false;
+    ckpt.read(fptr.data(), ntag * sizeof(uint32_t));
+    ckpt.read(rptr.data(), ndata * sizeof(uint32_t));
+    uint32_t n = ckpt.get<uint32_t>();
+    if(!ckpt.good() || n > ndata) return false;
+    occupied.resize(n);
+    free_list.resize(ndata - n);
+    ckpt.read(occupied.data(), n * sizeof(uint32_t));
+    ckpt.read(free_list.data(), (ndata - n) * sizeof(uint32_t));
+    if constexpr (!std::is_void<DT>::value) for(auto &d:data) d.restore(ckpt);
+    for(uint32_t i=0; i<n; i++) opos[occupied[i]] = i;
+    std::fill(load.begin(), load.end(), 0);
+    for(uint32_t t=0; t<ntag; t++) if(fptr[t] != none) load[t / TW]++;
+    pending = false;
+    return ckpt.good();
+  }
+};
+
+#endif
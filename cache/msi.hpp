@@ -2,6 +2,7 @@
 #define CM_CACHE_MSI_HPP
 
 #include <cassert>
+#include <vector>
 #include <type_traits>
 #include "cache/coherence.hpp"
 
@@ -18,7 +19,7 @@ namespace // file visibility
     //---------------------------------------
     // action:
     // Acquire: fetch for [0] read / [1] write
-    // Release: [0] evict / [1] writeback (keep modified)
+    // Release: [0] evict / [1] writeback (keep modified) / [2] evict a clean block (victim fill of exclusive caches)
     // Probe: [0] evict / [1] writeback (keep shared)
 
     constexpr static uint32_t acquire_msg = 1 << 8;
@@ -30,6 +31,7 @@ namespace // file visibility
 
     constexpr static uint32_t release_evict = 0;
     constexpr static uint32_t release_writeback = 1;
+    constexpr static uint32_t release_clean = 2;
 
     constexpr static uint32_t probe_evict = 0;
     constexpr static uint32_t probe_writeback = 1;
@@ -38,15 +40,19 @@ namespace // file visibility
     static inline bool is_acquire(uint32_t cmd) {return (cmd & 0x0ff00ul) == acquire_msg; }
     static inline bool is_release(uint32_t cmd) {return (cmd & 0x0ff00ul) == release_msg; }
     static inline bool is_probe(uint32_t cmd)   {return (cmd & 0x0ff00ul) == probe_msg; }
+    static inline bool is_acquire_write(uint32_t cmd) {return is_acquire(cmd) && acquire_write == get_action(cmd); }
+    static inline bool is_release_evict(uint32_t cmd) {return is_release(cmd) && release_writeback != get_action(cmd); } // the block leaves the releasing cache
+    static inline bool is_probe_evict(uint32_t cmd) {return is_probe(cmd) && probe_evict == get_action(cmd); }
     static inline uint32_t get_id(uint32_t cmd) {return cmd >> 16; }
     static inline uint32_t get_action(uint32_t cmd) {return cmd & 0x0fful; }
 
     // attach an id to a command
     static inline uint32_t attach_id(uint32_t cmd, uint32_t id) {return (cmd & (0x0fffful)) | (id << 16); }
 
-    // check whether reverse probing is needed for a cache block when acquired (by inner) or probed by (outer)
+    // check whether reverse probing is needed for a cache block when acquired (by inner), probed by (outer) or evicted
     static inline bool need_sync(uint32_t cmd, CMMetadataBase *meta) {
-      return (is_probe(cmd) && probe_evict == get_action(cmd)) || meta->is_modified() || (is_acquire(cmd) && acquire_write == get_action(cmd));
+      return is_probe_evict(cmd) || meta->is_modified() || (is_acquire(cmd) && acquire_write == get_action(cmd)) ||
+             (is_release(cmd) && release_evict == get_action(cmd)); // an inclusive cache invalidates the shared inner copies of an evicted block
     }
 
     // check whether a permission upgrade is needed for the required action
@@ -76,6 +82,9 @@ namespace // file visibility
     // command to evict a cache block from this cache
     static inline uint32_t cmd_for_evict() { return attach_id(release_msg | release_evict, -1); } // eviction needs no coh_id
 
+    // command to evict a clean cache block into an exclusive outer cache
+    static inline uint32_t cmd_for_evict_clean() { return attach_id(release_msg | release_clean, -1); }
+
     // command for core interface to read/write a cache block
     static inline uint32_t cmd_for_core_read() { return acquire_msg | acquire_read; }
     static inline uint32_t cmd_for_core_write() { return acquire_msg | acquire_write; }
@@ -108,25 +117,55 @@ namespace // file visibility
     static inline void meta_after_writeback(uint32_t cmd, CMMetadataBase *meta) {
       assert(is_release(cmd)); // must be an acquire
       meta->to_clean();
-      if(release_evict == get_action(cmd)) meta->to_invalid();
+      if(release_writeback != get_action(cmd)) meta->to_invalid();
     }
 
     // set the meta after the block is released
-    static inline void meta_after_release(uint32_t cmd, CMMetadataBase *meta) { meta->to_dirty(); }
+    static inline void meta_after_release(uint32_t cmd, CMMetadataBase *meta) {
+      if(release_clean != get_action(cmd)) meta->to_dirty();
+    }
 
     // update the metadata for inner cache after ack a probe
     static inline void meta_after_probe_ack(uint32_t cmd, CMMetadataBase *meta) {
       assert(is_probe(cmd)); // must be a probe
       if(probe_evict == get_action(cmd))
         meta->to_invalid();
-      else {
-        assert(meta->is_modified()); // for MSI, probe degradation happens only for modified state
+      else if(meta->is_modified()) // a shared block may be probed by a non-inclusive outer cache which does not track it
         meta->to_shared();
-      }
     }
 
   };
 
+  // sectored data (see DataSectored): fill the words of need missing in the block data
+  //   through an acquire (or a promotion) of the block, a no-op wrapper of acquire_req() for full blocks
+  template<typename DT>
+  inline void acquire_sectors(OuterCohPortBase *outer, uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint64_t need, uint32_t cmd, uint64_t *delay) {
+    if constexpr (is_data_sectored<DT>) if(data) static_cast<DT *>(data)->fetch(need);
+    outer->acquire_req(addr, meta, data, cmd, delay);
+    if constexpr (is_data_sectored<DT>) if(data) static_cast<DT *>(data)->fetched();
+  }
+
+  //   or through a data-only fetch of a block already held, return whether any word is fetched
+  template<typename DT>
+  inline bool fetch_sectors(OuterCohPortBase *outer, uint64_t addr, CMDataBase *data, uint64_t need, uint64_t *delay) {
+    if constexpr (is_data_sectored<DT>) {
+      auto d = static_cast<DT *>(data);
+      if(d && d->missing(need)) {
+        d->fetch(need);
+        outer->fetch_req(addr, d, delay);
+        d->fetched();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // a block replaced by a miss holds no word
+  template<typename DT>
+  inline void reset_sectors(CMDataBase *data) {
+    if constexpr (is_data_sectored<DT>) if(data) data->reset();
+  }
+
 }
 
 // metadata supporting MSI coherency
@@ -168,6 +207,11 @@ public:
   virtual bool match(uint64_t addr) const { return is_valid() && ((addr >> TOfst) & mask) == tag; }
   virtual void reset() { tag = 0; state = 0; dirty = 0; }
   virtual void init(uint64_t addr) { tag = (addr >> TOfst) & mask; state = 0; dirty = 0; }
+  virtual void save(CheckpointWriter &ckpt) const { ckpt.put<uint64_t>(tag | ((uint64_t)state << (AW-TOfst)) | ((uint64_t)dirty << (AW-TOfst+2))); }
+  virtual void restore(CheckpointReader &ckpt) {
+    uint64_t v = ckpt.get<uint64_t>();
+    tag = v & mask; state = (v >> (AW-TOfst)) & 3; dirty = (v >> (AW-TOfst+2)) & 1;
+  }
   virtual uint64_t addr(uint32_t s) const {
     uint64_t addr = tag << TOfst;
     if(IW > 0) {
@@ -189,13 +233,24 @@ class OuterPortMSIUncached : public OuterCohPortBase
 {
 public:
   virtual void acquire_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
+    this->cache->hook_message(addr, meta->match(addr) ? CohMsgType::promote : CohMsgType::acquire, coh->get_id(addr));
     coh->acquire_resp(addr, data, Policy::attach_id(cmd, this->coh_id), delay);
     Policy::meta_after_grant(cmd, meta, addr);
   }
   virtual void writeback_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
+    this->cache->hook_message(addr, CohMsgType::writeback, coh->get_id(addr));
     coh->writeback_resp(addr, data, Policy::attach_id(cmd, this->coh_id), delay);
     Policy::meta_after_writeback(cmd, meta);
   }
+  virtual bool evict_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint64_t *delay) {
+    if(!meta->is_dirty()) return false;
+    writeback_req(addr, meta, data, Policy::cmd_for_evict(), delay);
+    return true;
+  }
+  virtual void fetch_req(uint64_t addr, CMDataBase *data, uint64_t *delay) {
+    this->cache->hook_message(addr, CohMsgType::fetch, coh->get_id(addr));
+    coh->fetch_resp(addr, data, delay);
+  }
 };
 
 // full MSI Outer port
@@ -209,17 +264,16 @@ public:
     if(this->cache->hit(addr, &ai, &s, &w)) {
       auto meta = this->cache->access(ai, s, w); // oddly here, `this->' is required by the g++ 11.3.0 @wsong83
       CMDataBase *data = nullptr;
-      if constexpr (!std::is_void<DT>::value) {
-        data = this->cache->get_data(ai, s, w);
-      }
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
 
       // sync if necessary
       if(Policy::need_sync(cmd, meta)) this->inner->probe_req(addr, meta, data, Policy::cmd_for_sync(cmd), delay);
 
       // writeback if dirty
       if(writeback = meta->is_dirty()) { // dirty, writeback
+        this->cache->hook_message(addr, CohMsgType::probe_data, this->coh->get_id(addr));
         meta_outer->to_dirty();
-        if constexpr (!std::is_void<DT>::value) data_outer->copy(data);
+        if constexpr (!std::is_void<DT>::value) if(data && data_outer) data_outer->copy(data);
         meta->to_clean();
       }
 
@@ -230,6 +284,20 @@ public:
   }
 };
 
+// MSI outer port of an inner cache of an exclusive cache:
+//   clean blocks are also released to the outer cache when evicted (victim fill)
+template<typename MT, typename DT>
+class OuterPortMSIExclusive : public OuterPortMSI<MT, DT>
+{
+public:
+  virtual bool evict_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint64_t *delay) {
+    if constexpr (is_data_sectored<DT>) // a partial clean block is dropped
+      if(!meta->is_dirty() && data && static_cast<DT *>(data)->missing(DT::all)) return false;
+    this->writeback_req(addr, meta, data, meta->is_dirty() ? Policy::cmd_for_evict() : Policy::cmd_for_evict_clean(), delay);
+    return true;
+  }
+};
+
 // uncached MSI inner port:
 //   no support for reverse probe as if there is no internal cache
 //   or the interl cache does not participate in the coherence communication
@@ -238,37 +306,58 @@ template<typename MT, typename DT, bool isLLC,
          typename = typename std::enable_if<std::is_base_of<CMDataBase, DT>::value || std::is_void<DT>::value>::type> // DT <- CMDataBase or void
 class InnerPortMSIUncached : public InnerCohPortBase
 {
+protected:
+  // evict the block in (ai, s, w) to make room for a new block
+  //   sync: probe the inner caches (back-invalidation of an inclusive cache)
+  void evict(CMMetadataBase *meta, CMDataBase *data, uint32_t ai, uint32_t s, uint32_t w, bool sync, uint64_t *delay) {
+    auto replace_addr = meta->addr(s);
+    if(sync && Policy::need_sync(Policy::cmd_for_evict(), meta)) probe_req(replace_addr, meta, data, Policy::cmd_for_sync(Policy::cmd_for_evict()), delay); // sync if necessary
+    bool writeback = outer->evict_req(replace_addr, meta, data, delay); // writeback if dirty
+    this->cache->hook_invalid(replace_addr, ai, s, w, writeback, delay);
+  }
+
+  // evict the extra blocks required by the block being filled for addr
+  void evict_extra(uint64_t addr, bool sync, uint64_t *delay) {
+    uint32_t ai, s, w;
+    while(this->cache->replace_extra(addr, &ai, &s, &w)) {
+      CMDataBase *data = nullptr;
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
+      auto meta = this->cache->access(ai, s, w);
+      evict(meta, data, ai, s, w, sync, delay);
+      meta->to_invalid(); // not overwritten by a fill
+    }
+  }
+
 public:
   virtual void acquire_resp(uint64_t addr, CMDataBase *data_inner, uint32_t cmd, uint64_t *delay) {
     uint32_t ai, s, w;
     CMMetadataBase *meta;
-    CMDataBase *data;
-    bool hit, writeback;
+    CMDataBase *data = nullptr;
+    bool hit;
+    uint64_t need = data_inner ? data_inner->requested() : ~0ull; // words requested by a sectored inner block
     if(hit = this->cache->hit(addr, &ai, &s, &w)) { // hit
       meta = this->cache->access(ai, s, w);
       if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
       if(Policy::need_sync(cmd, meta)) probe_req(addr, meta, data, Policy::cmd_for_sync(cmd), delay); // sync if necessary
       if(Policy::need_promote(cmd, meta) && !isLLC) {  // promote permission if needed
-        outer->acquire_req(addr, meta, data, cmd, delay);
+        acquire_sectors<DT>(outer, addr, meta, data, need, cmd, delay);
+        hit = false;
+      } else if(fetch_sectors<DT>(outer, addr, data, need, delay)) // missing sectors
         hit = false;
-      }
     } else { // miss
       // get the way to be replaced
-      this->cache->replace(addr, &ai, &s, &w);
+      this->cache->replace(addr, &ai, &s, &w, Policy::get_id(cmd));
       meta = this->cache->access(ai, s, w);
       if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
-      if(meta->is_valid()) {
-        auto replace_addr = meta->addr(s);
-        if(Policy::need_sync(Policy::cmd_for_evict(), meta)) probe_req(replace_addr, meta, data, Policy::cmd_for_sync(Policy::cmd_for_evict()), delay); // sync if necessary
-        if(writeback = meta->is_dirty()) outer->writeback_req(replace_addr, meta, data, Policy::cmd_for_evict(), delay); // writeback if dirty
-        this->cache->hook_invalid(replace_addr, ai, s, w, writeback, delay);
-      }
-      outer->acquire_req(addr, meta, data, cmd, delay); // fetch the missing block
+      if(meta->is_valid()) evict(meta, data, ai, s, w, true, delay);
+      evict_extra(addr, true, delay);
+      reset_sectors<DT>(data);
+      acquire_sectors<DT>(outer, addr, meta, data, need, cmd, delay); // fetch the missing block
     }
     // grant
-    if constexpr (!std::is_void<DT>::value) data_inner->copy(this->cache->get_data(ai, s, w));
+    if constexpr (!std::is_void<DT>::value) if(data && data_inner) data_inner->copy(data);
     Policy::meta_after_acquire(cmd, meta);
-    this->cache->hook_read(addr, ai, s, w, hit, delay);
+    this->cache->hook_read(addr, ai, s, w, hit, delay, Policy::get_id(cmd));
   }
 
   virtual void writeback_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
@@ -277,9 +366,25 @@ public:
     auto h = this->cache->hit(addr, &ai, &s, &w);
     assert(h); // must hit
     meta = this->cache->access(ai, s, w);
-    if constexpr (!std::is_void<DT>::value) this->cache->get_data(ai, s, w)->copy(data);
+    if constexpr (!std::is_void<DT>::value) if(data) this->cache->get_data(ai, s, w)->copy(data);
     Policy::meta_after_release(cmd, meta);
-    this->cache->hook_write(addr, ai, s, w, true, delay);
+    this->cache->hook_write(addr, ai, s, w, true, delay, Policy::get_id(cmd));
+  }
+
+  // supply the missing sectors of a block held by an inner cache, forwarded to the outer cache if not cached here
+  virtual void fetch_resp(uint64_t addr, CMDataBase *data_inner, uint64_t *delay) {
+    uint32_t ai, s, w;
+    if(this->cache->hit(addr, &ai, &s, &w)) {
+      CMDataBase *data = nullptr;
+      bool hit = true;
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
+      if(data_inner && fetch_sectors<DT>(outer, addr, data, data_inner->requested(), delay)) hit = false;
+      if constexpr (!std::is_void<DT>::value) if(data && data_inner) data_inner->copy(data);
+      this->cache->hook_read(addr, ai, s, w, hit, delay);
+    } else {
+      outer->fetch_req(addr, data_inner, delay);
+      this->cache->hook_bypass(addr, delay);
+    }
   }
 };
 
@@ -289,9 +394,248 @@ class InnerPortMSIBroadcast : public InnerPortMSIUncached<MT, DT, isLLC>
 {
 public:
   virtual void probe_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
+    CM_PROFILE_SCOPE(this->cache->get_profile(), PROBE);
     for(uint32_t i=0; i<this->coh.size(); i++)
-      if(Policy::need_probe(cmd, i))
+      if(Policy::need_probe(cmd, i)) {
+        this->cache->hook_message(addr, CohMsgType::probe, this->coh[i]->get_id());
         this->coh[i]->probe_resp(addr, meta, data, cmd, delay);
+      }
+  }
+};
+
+// non-inclusive MSI inner port (broadcasting hub, snoop):
+//   blocks are allocated on fetch as in an inclusive cache but evicted without back-invalidating
+//   the inner caches, so a missing block may still be cached inside: the inner caches are probed
+//   for the latest copy on a miss, and a written back block is allocated again (victim fill).
+//   Probes from an outer cache are not forwarded to the inner caches on a miss, so a non-inclusive
+//   cache should be the last level (or its outer cache should not probe).
+template<typename MT, typename DT, bool isLLC>
+class InnerPortMSINonInclusive : public InnerPortMSIBroadcast<MT, DT, isLLC>
+{
+protected:
+  // allocate a block for addr requested by partition part, which is initialized but not yet valid
+  CMMetadataBase *allocate(uint64_t addr, uint32_t part, uint32_t *ai, uint32_t *s, uint32_t *w, CMDataBase **data, uint64_t *delay) {
+    this->cache->replace(addr, ai, s, w, part);
+    auto meta = this->cache->access(*ai, *s, *w);
+    *data = nullptr;
+    if constexpr (!std::is_void<DT>::value) *data = this->cache->get_data(*ai, *s, *w);
+    if(meta->is_valid()) this->evict(meta, *data, *ai, *s, *w, false, delay); // no back-invalidation
+    this->evict_extra(addr, false, delay);
+    reset_sectors<DT>(*data);
+    meta->init(addr);
+    return meta;
+  }
+
+public:
+  virtual void acquire_resp(uint64_t addr, CMDataBase *data_inner, uint32_t cmd, uint64_t *delay) {
+    uint32_t ai, s, w;
+    CMMetadataBase *meta;
+    CMDataBase *data = nullptr;
+    bool hit;
+    uint64_t need = data_inner ? data_inner->requested() : ~0ull; // words requested by a sectored inner block
+    if(hit = this->cache->hit(addr, &ai, &s, &w)) { // hit
+      meta = this->cache->access(ai, s, w);
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
+      if(Policy::need_sync(cmd, meta)) this->probe_req(addr, meta, data, Policy::cmd_for_sync(cmd), delay); // sync if necessary
+      if(Policy::need_promote(cmd, meta) && !isLLC) {  // promote permission if needed
+        acquire_sectors<DT>(this->outer, addr, meta, data, need, cmd, delay);
+        hit = false;
+      } else if(fetch_sectors<DT>(this->outer, addr, data, need, delay)) // missing sectors
+        hit = false;
+    } else { // miss
+      meta = allocate(addr, Policy::get_id(cmd), &ai, &s, &w, &data, delay);
+      this->probe_req(addr, meta, data, Policy::cmd_for_sync(cmd), delay);   // an inner cache may hold the block
+      if(!meta->is_dirty()) acquire_sectors<DT>(this->outer, addr, meta, data, need, cmd, delay); // fetch unless supplied by a probe
+    }
+    // grant
+    if constexpr (!std::is_void<DT>::value) if(data && data_inner) data_inner->copy(data);
+    Policy::meta_after_acquire(cmd, meta);
+    this->cache->hook_read(addr, ai, s, w, hit, delay, Policy::get_id(cmd));
+  }
+
+  virtual void writeback_resp(uint64_t addr, CMDataBase *data_inner, uint32_t cmd, uint64_t *delay) {
+    uint32_t ai, s, w;
+    CMMetadataBase *meta;
+    CMDataBase *data = nullptr;
+    bool hit;
+    if(hit = this->cache->hit(addr, &ai, &s, &w)) {
+      meta = this->cache->access(ai, s, w);
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
+    } else { // the block has been evicted, allocate it again
+      meta = allocate(addr, Policy::get_id(cmd), &ai, &s, &w, &data, delay);
+      meta->to_shared(); // a released block is not modified by any inner cache
+    }
+    if constexpr (!std::is_void<DT>::value) if(data && data_inner) data->copy(data_inner);
+    Policy::meta_after_release(cmd, meta);
+    this->cache->hook_write(addr, ai, s, w, hit, delay, Policy::get_id(cmd));
+  }
+};
+
+// exclusive MSI inner port (broadcasting hub, snoop):
+//   a block fetched from the outer cache is granted to the inner cache without being allocated,
+//   a hitting block is moved to the inner cache (unless dirty, which is kept rather than written back),
+//   and blocks are allocated when released by the inner caches (use OuterPortMSIExclusive for them
+//   to release clean blocks as well). Also a last-level cache as a non-inclusive one.
+template<typename MT, typename DT, bool isLLC>
+class InnerPortMSIExclusive : public InnerPortMSINonInclusive<MT, DT, isLLC>
+{
+public:
+  virtual void acquire_resp(uint64_t addr, CMDataBase *data_inner, uint32_t cmd, uint64_t *delay) {
+    uint32_t ai, s, w;
+    if(this->cache->hit(addr, &ai, &s, &w)) { // hit
+      auto meta = this->cache->access(ai, s, w);
+      CMDataBase *data = nullptr;
+      bool hit = true;
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
+      if(Policy::need_sync(cmd, meta)) this->probe_req(addr, meta, data, Policy::cmd_for_sync(cmd), delay); // sync if necessary
+      if(Policy::need_promote(cmd, meta) && !isLLC) {  // promote permission if needed
+        acquire_sectors<DT>(this->outer, addr, meta, data, data_inner ? data_inner->requested() : ~0ull, cmd, delay);
+        hit = false;
+      } else if(data_inner && fetch_sectors<DT>(this->outer, addr, data, data_inner->requested(), delay)) // missing sectors
+        hit = false;
+      // grant
+      if constexpr (!std::is_void<DT>::value) if(data && data_inner) data_inner->copy(data);
+      Policy::meta_after_acquire(cmd, meta);
+      this->cache->hook_read(addr, ai, s, w, hit, delay, Policy::get_id(cmd));
+      if(!meta->is_dirty()) { // move the block to the inner cache (off the critical path)
+        meta->to_invalid();
+        this->cache->hook_invalid(addr, ai, s, w, false, nullptr);
+      }
+    } else { // miss, fetch the block for the inner cache without allocating it
+      MT meta;
+      meta.init(addr);
+      // a sectored inner block filling part of the block collects a probed dirty block in a whole block
+      typename std::conditional<std::is_void<DT>::value, CMDataBase, DT>::type whole;
+      CMDataBase *data = data_inner;
+      if constexpr (!std::is_void<DT>::value) if(data_inner && ~data_inner->requested()) { whole.reset(); data = &whole; }
+      this->probe_req(addr, &meta, data, Policy::cmd_for_sync(cmd), delay); // an inner cache may hold the block
+      if(!meta.is_dirty())
+        this->outer->acquire_req(addr, &meta, data_inner, cmd, delay);
+      else {
+        if(data != data_inner) data_inner->copy(data);
+        if(!Policy::is_acquire_write(cmd)) // dirty data is left in shared inner copies only, write it back
+          this->outer->writeback_req(addr, &meta, data, Policy::cmd_for_evict(), delay);
+      }
+      this->cache->hook_bypass(addr, delay);
+    }
+  }
+};
+
+// MSI inner port with a snoop filter (broadcasting hub, snoop):
+//   A set-associative tag-only array (2^IW sets of NW ways, LRU, indexed by the address bits above
+//   IOfst) per inner cache records the blocks the inner cache may hold, and probes skip the inner
+//   caches which certainly do not hold the block. Clean blocks are dropped silently by inner caches,
+//   so an entry may be stale but a cached block is never missing: a block losing its entry is
+//   back-invalidated from the inner cache (off the critical path).
+//   The hub is inclusive (InnerPortMSIBroadcast) or non-inclusive (InnerPortMSINonInclusive),
+//   where the filter also avoids most probes of the inner caches on a miss.
+template<typename MT, typename DT, bool isLLC, int IW, int NW, int IOfst, bool nonInclusive>
+class InnerPortMSISnoopFilter : public std::conditional<nonInclusive, InnerPortMSINonInclusive<MT, DT, isLLC>, InnerPortMSIBroadcast<MT, DT, isLLC> >::type
+{
+  typedef typename std::conditional<nonInclusive, InnerPortMSINonInclusive<MT, DT, isLLC>, InnerPortMSIBroadcast<MT, DT, isLLC> >::type BaseT;
+  constexpr static uint32_t nset = 1ul << IW;
+  constexpr static uint64_t invalid = ~0ull;
+
+protected:
+  std::vector<uint64_t> filter;      // [inner cache][set][way] block address (addr >> IOfst), MRU first
+  uint64_t cnt_filtered, cnt_back_invalid;
+
+  uint64_t *filter_set(uint32_t c, uint64_t addr) {
+    return filter.data() + ((uint64_t)c * nset + ((addr >> IOfst) & (nset - 1))) * NW;
+  }
+
+  bool filter_hit(uint32_t c, uint64_t addr) {
+    auto set = filter_set(c, addr);
+    for(int i=0; i<NW; i++) if(set[i] == (addr >> IOfst)) return true;
+    return false;
+  }
+
+  // record addr as the MRU entry, return the address losing its entry or invalid
+  uint64_t filter_insert(uint32_t c, uint64_t addr) {
+    auto set = filter_set(c, addr);
+    uint64_t blk = addr >> IOfst;
+    int i = 0;
+    while(i < NW - 1 && set[i] != blk) i++; // the LRU entry is replaced if not found
+    uint64_t victim = set[i] == blk ? invalid : set[i];
+    for(; i>0; i--) set[i] = set[i-1];
+    set[0] = blk;
+    return victim == invalid ? invalid : victim << IOfst;
+  }
+
+  void filter_remove(uint32_t c, uint64_t addr) {
+    auto set = filter_set(c, addr);
+    int i = 0;
+    while(i < NW && set[i] != (addr >> IOfst)) i++;
+    if(i == NW) return;
+    for(; i<NW-1; i++) set[i] = set[i+1];
+    set[NW-1] = invalid;
+  }
+
+  // invalidate a block in the inner cache c as its filter entry is replaced
+  void back_invalidate(uint32_t c, uint64_t addr) {
+    uint32_t ai, s, w;
+    auto cmd = Policy::cmd_for_sync(Policy::cmd_for_evict());
+    cnt_back_invalid++;
+    this->cache->hook_message(addr, CohMsgType::probe, this->coh[c]->get_id());
+    if(this->cache->hit(addr, &ai, &s, &w)) { // dirty data is written into this cache
+      CMDataBase *data = nullptr;
+      if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
+      this->coh[c]->probe_resp(addr, this->cache->access(ai, s, w), data, cmd, nullptr);
+    } else { // not cached here (non-inclusive), dirty data is written back to the outer cache
+      MT meta;
+      CMDataBase *data = nullptr;
+      if constexpr (!std::is_void<DT>::value) data = new DT();
+      meta.init(addr);
+      meta.to_shared();
+      this->coh[c]->probe_resp(addr, &meta, data, cmd, nullptr);
+      if(meta.is_dirty()) this->outer->writeback_req(addr, &meta, data, Policy::cmd_for_evict(), nullptr);
+      if constexpr (!std::is_void<DT>::value) delete data;
+    }
+  }
+
+public:
+  InnerPortMSISnoopFilter() : cnt_filtered(0), cnt_back_invalid(0) {}
+  virtual ~InnerPortMSISnoopFilter() {}
+
+  virtual uint32_t connect(CohClientBase *c) {
+    filter.resize(filter.size() + nset * NW, invalid);
+    return BaseT::connect(c);
+  }
+
+  virtual void acquire_resp(uint64_t addr, CMDataBase *data_inner, uint32_t cmd, uint64_t *delay) {
+    BaseT::acquire_resp(addr, data_inner, cmd, delay);
+    auto id = Policy::get_id(cmd);
+    auto victim = filter_insert(id, addr);
+    if(victim != invalid) back_invalidate(id, victim);
+  }
+
+  virtual void writeback_resp(uint64_t addr, CMDataBase *data_inner, uint32_t cmd, uint64_t *delay) {
+    BaseT::writeback_resp(addr, data_inner, cmd, delay);
+    if(Policy::is_release_evict(cmd)) filter_remove(Policy::get_id(cmd), addr);
+  }
+
+  virtual void probe_req(uint64_t addr, CMMetadataBase *meta, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
+    CM_PROFILE_SCOPE(this->cache->get_profile(), PROBE);
+    for(uint32_t i=0; i<this->coh.size(); i++)
+      if(Policy::need_probe(cmd, i)) {
+        if(!filter_hit(i, addr)) { cnt_filtered++; continue; }
+        this->cache->hook_message(addr, CohMsgType::probe, this->coh[i]->get_id());
+        this->coh[i]->probe_resp(addr, meta, data, cmd, delay);
+        if(Policy::is_probe_evict(cmd)) filter_remove(i, addr);
+      }
+  }
+
+  uint64_t get_filtered() const { return cnt_filtered; }         // probes avoided by the filter
+  uint64_t get_back_invalid() const { return cnt_back_invalid; } // back-invalidations caused by filter replacement
+
+  // checkpoint the filter
+  virtual void save(CheckpointWriter &ckpt) const {
+    ckpt.put<uint32_t>(this->coh.size());
+    ckpt.write(filter.data(), filter.size() * sizeof(uint64_t));
+  }
+  virtual bool restore(CheckpointReader &ckpt) {
+    return ckpt.expect<uint32_t>(this->coh.size(), "number of inner caches of a snoop filter") &&
+           ckpt.read(filter.data(), filter.size() * sizeof(uint64_t));
   }
 };
 
@@ -306,13 +650,19 @@ class CoreInterfaceMSI : public CoreInterfaceBase
     CMMetadataBase *meta;
     CMDataBase *data = nullptr;
     bool hit, writeback;
+    if(this->cache->is_fast_forward()) delay = nullptr; // no delay estimation in fast-forward
+    // words needed by a sectored block: the sector of addr on a read, the whole block on a write
+    //   (a modified block holds all its words, so probes and writebacks always carry complete blocks)
+    uint64_t need = ~0ull;
+    if constexpr (is_data_sectored<DT>) if(cmd != Policy::cmd_for_core_write()) need = DT::sector_mask(addr);
     if(hit = this->cache->hit(addr, &ai, &s, &w)) { // hit
       meta = this->cache->access(ai, s, w);
       if constexpr (!std::is_void<DT>::value) data = this->cache->get_data(ai, s, w);
       if(Policy::need_promote(cmd, meta) && !isLLC) {
-        outer->acquire_req(addr, meta, data, cmd, delay);
+        acquire_sectors<DT>(outer, addr, meta, data, need, cmd, delay);
+        hit = false;
+      } else if(fetch_sectors<DT>(outer, addr, data, need, delay)) // sector miss
         hit = false;
-      }
     } else { // miss
       // get the way to be replaced
       this->cache->replace(addr, &ai, &s, &w);
@@ -321,13 +671,21 @@ class CoreInterfaceMSI : public CoreInterfaceBase
 
       if(meta->is_valid()) {
         auto replace_addr = meta->addr(s);
-        // writeback if dirty
-        if(meta->is_dirty()) outer->writeback_req(replace_addr, meta, data, Policy::cmd_for_evict(), delay);
+        writeback = outer->evict_req(replace_addr, meta, data, delay); // writeback if dirty
         this->cache->hook_invalid(replace_addr, ai, s, w, writeback, delay);
       }
+      uint32_t xai, xs, xw;
+      while(this->cache->replace_extra(addr, &xai, &xs, &xw)) { // extra blocks evicted for the fill
+        auto xmeta = this->cache->access(xai, xs, xw);
+        auto xaddr = xmeta->addr(xs);
+        writeback = outer->evict_req(xaddr, xmeta, this->cache->get_data(xai, xs, xw), delay);
+        this->cache->hook_invalid(xaddr, xai, xs, xw, writeback, delay);
+        xmeta->to_invalid();
+      }
 
       // fetch the missing block
-      outer->acquire_req(addr, meta, data, cmd, delay);
+      reset_sectors<DT>(data);
+      acquire_sectors<DT>(outer, addr, meta, data, need, cmd, delay);
     }
 
     if(cmd == Policy::cmd_for_core_write()) {
@@ -345,7 +703,10 @@ public:
 
   virtual void write(uint64_t addr, const CMDataBase *data, uint64_t *delay) {
     auto m_data = access(addr, Policy::cmd_for_core_write(), EnableDelay ? delay : nullptr);
-    if constexpr (!std::is_void<DT>::value) m_data->copy(data);
+    if constexpr (!std::is_void<DT>::value) if(data && m_data) { // a null data only updates the cache state
+      if constexpr (is_data_sectored<DT>) static_cast<DT *>(m_data)->copy(data, DT::sector_mask(addr)); // the written sector
+      else m_data->copy(data);
+    }
   }
 
   virtual void flush(uint64_t addr, uint64_t *delay) {
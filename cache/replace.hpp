@@ -1,10 +1,11 @@
 #ifndef CM_REPLACE_HPP_
 #define CM_REPLACE_HPP_
 
-#include <list>
-#include <unordered_set>
-#include <unordered_map>
+#include <cstdlib>
+#include <vector>
+#include <type_traits>
 #include "util/random.hpp"
+#include "util/checkpoint.hpp"
 
 ///////////////////////////////////
 // Base class
@@ -16,63 +17,175 @@ protected:
 public:
   ReplaceFuncBase(uint32_t nset) : nset(nset) {};
   virtual uint32_t replace(uint32_t s, uint32_t *w) = 0;
+  // replace a way allowed by mask (way partitioning), the lowest allowed way unless overridden
+  virtual uint32_t replace_masked(uint32_t s, uint32_t *w, uint64_t mask) {
+    auto rv = replace(s, w);
+    if(!((mask >> *w) & 1)) *w = __builtin_ctzll(mask);
+    return rv;
+  }
   virtual void access(uint32_t s, uint32_t w) = 0;
   virtual void invalid(uint32_t s, uint32_t w) = 0;
+  virtual void save(CheckpointWriter &ckpt) const {}
+  virtual bool restore(CheckpointReader &ckpt) { return true; }
   virtual ~ReplaceFuncBase() {}
 };
 
+// FIFO replacement, free ways are used first (the lowest one)
+//   A valid-way bitmask (of NWW words) and the valid ways in the order of replacement per set, both allocated
+//   by calloc() so that the sets untouched in a huge cache take no memory (zeroed on demand by the OS).
+//   Way masks (replace_masked) cover the first 64 ways.
 template<int IW, int NW>
 class ReplaceFIFO : public ReplaceFuncBase
 {
+  static_assert(NW <= 65536, "ReplaceFIFO and ReplaceLRU support no more than 65536 ways");
 protected:
-  std::unordered_map<uint32_t, std::list<uint32_t> > used_map;
-  std::unordered_map<uint32_t, std::unordered_set<uint32_t> > free_map;
+  constexpr static int NWW = (NW + 63) / 64; // words of a valid-way bitmask
+  typedef typename std::conditional<NW <= 256, uint8_t, uint16_t>::type WayT;
+  uint64_t *used;  // valid ways of each set
+  WayT *order;     // valid ways of each set, the next to be replaced first
+
+  // the ways of word i of a bitmask
+  constexpr static uint64_t word_mask(int i) { return (i < NWW - 1 || NW % 64 == 0) ? ~0ull : (1ull << (NW % 64)) - 1; }
+
+  void allocate() {
+    used = static_cast<uint64_t *>(calloc((uint64_t)nset * NWW, sizeof(uint64_t)));
+    order = static_cast<WayT *>(calloc((uint64_t)nset * NW, sizeof(WayT)));
+  }
+
+  uint64_t *set_used(uint32_t s) const { return used + (uint64_t)s * NWW; }
+  WayT *set_order(uint32_t s) const { return order + (uint64_t)s * NW; }
+  bool is_used(uint32_t s, uint32_t w) const { return (set_used(s)[w / 64] >> (w % 64)) & 1; }
+
+  // number of valid ways in set s
+  uint32_t count(uint32_t s) const {
+    uint32_t n = 0;
+    for(int i=0; i<NWW; i++) n += __builtin_popcountll(set_used(s)[i]);
+    return n;
+  }
+
+  // append way w to the order of set s
+  void push(uint32_t s, uint32_t w) {
+    set_order(s)[count(s)] = w;
+    set_used(s)[w / 64] |= 1ull << (w % 64);
+  }
+
+  // remove way w from the order of set s
+  void remove(uint32_t s, uint32_t w) {
+    auto o = set_order(s);
+    uint32_t n = count(s), i = 0;
+    while(o[i] != w) i++;
+    for(; i+1<n; i++) o[i] = o[i+1];
+    set_used(s)[w / 64] &= ~(1ull << (w % 64));
+  }
 
 public:
-  ReplaceFIFO() : ReplaceFuncBase(1ul<<IW) {}
-  virtual ~ReplaceFIFO() {}
-  virtual uint32_t replace(uint32_t s, uint32_t *w){
-    if(!free_map.count(s))
-      for(uint32_t i=0; i<NW; i++) free_map[s].insert(i);
-    if(free_map[s].size() > 0)
-      *w = *(free_map[s].begin());
-    else
-      *w = used_map[s].front();
+  ReplaceFIFO() : ReplaceFuncBase(1ul<<IW) { allocate(); }
+  virtual ~ReplaceFIFO() {
+    std::free(used);
+    std::free(order);
+  }
 
+  virtual uint32_t replace(uint32_t s, uint32_t *w){
+    auto u = set_used(s);
+    for(int i=0; i<NWW; i++) {
+      uint64_t free = ~u[i] & word_mask(i);
+      if(free) { *w = i * 64 + __builtin_ctzll(free); return 0; }
+    }
+    *w = set_order(s)[0];
+    return 0;
+  }
+  virtual uint32_t replace_masked(uint32_t s, uint32_t *w, uint64_t mask){
+    uint64_t free = ~set_used(s)[0] & mask & word_mask(0);
+    if(free) { *w = __builtin_ctzll(free); return 0; }
+    auto o = set_order(s);
+    for(uint32_t i=0, n=count(s); i<n; i++) if(o[i] < 64 && ((mask >> o[i]) & 1)) { *w = o[i]; return 0; }
     return 0;
   }
   virtual void access(uint32_t s, uint32_t w) {
-    if(free_map[s].count(w)) {
-      free_map[s].erase(w);
-      used_map[s].push_back(w);
-    }
+    if(!is_used(s, w)) push(s, w);
   }
   virtual void invalid(uint32_t s, uint32_t w){
-    used_map[s].remove(w);
-    free_map[s].insert(w);
+    if(is_used(s, w)) remove(s, w);
+  }
+
+  // checkpoint: the sets with valid ways, their bitmasks and orders
+  virtual void save(CheckpointWriter &ckpt) const {
+    ckpt.put<uint32_t>(nset);
+    ckpt.put<uint32_t>(NW);
+    std::vector<uint32_t> sets;
+    for(uint32_t s=0; s<nset; s++) if(count(s)) sets.push_back(s);
+    ckpt.put<uint32_t>(sets.size());
+    for(auto s:sets) {
+      ckpt.put<uint32_t>(s);
+      ckpt.write(set_used(s), NWW * sizeof(uint64_t));
+      ckpt.write(set_order(s), count(s) * sizeof(WayT));
+    }
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!ckpt.expect<uint32_t>(nset, "number of sets of a replacer") || !ckpt.expect<uint32_t>(NW, "number of ways of a replacer")) return false;
+    std::free(used);
+    std::free(order);
+    allocate(); // sets not in the checkpoint are untouched
+    for(uint32_t n = ckpt.get<uint32_t>(); n > 0 && ckpt.good(); n--) {
+      auto s = ckpt.get<uint32_t>();
+      if(!ckpt.good() || s >= nset || !ckpt.read(set_used(s), NWW * sizeof(uint64_t))) return false;
+      for(int i=0; i<NWW; i++) if(set_used(s)[i] & ~word_mask(i)) return false;
+      ckpt.read(set_order(s), count(s) * sizeof(WayT));
+    }
+    return ckpt.good();
   }
 };
 
+// LRU replacement, the order of a set is from the least to the most recently used way
 template<int IW, int NW>
 class ReplaceLRU : public ReplaceFIFO<IW, NW>
 {
 public:
-  using ReplaceFIFO<IW,NW>::free_map;
-  using ReplaceFIFO<IW,NW>::used_map;
-  
   ReplaceLRU() : ReplaceFIFO<IW,NW>() {}
   ~ReplaceLRU() {}
 
   virtual void access(uint32_t s, uint32_t w) {
-    if(free_map[s].count(w)) {
-      free_map[s].erase(w);
-      used_map[s].push_back(w);
+    if(this->is_used(s, w)) {
+      if(this->set_order(s)[this->count(s) - 1] == w) return; // already the MRU
+      this->remove(s, w);
     }
-    else{
-      used_map[s].remove(w);
-      used_map[s].push_back(w);
+    this->push(s, w);
+  }
+};
+
+// random replacement, free ways are used first (a valid-way bitmask per set, no other state)
+template<int IW, int NW>
+class ReplaceRandom : public ReplaceFuncBase
+{
+  static_assert(NW <= 64, "ReplaceRandom supports no more than 64 ways");
+protected:
+  std::vector<uint64_t> used; // valid ways of each set
+
+public:
+  ReplaceRandom() : ReplaceFuncBase(1ul<<IW), used(1ul<<IW, 0) {}
+  virtual ~ReplaceRandom() {}
+
+  virtual uint32_t replace(uint32_t s, uint32_t *w) {
+    uint64_t free = ~used[s] & (NW == 64 ? ~0ull : (1ull << NW) - 1);
+    *w = free ? __builtin_ctzll(free) : cm_get_random_uint32() % NW;
+    return 0;
+  }
+  virtual uint32_t replace_masked(uint32_t s, uint32_t *w, uint64_t mask) {
+    uint64_t free = ~used[s] & mask;
+    if(free) *w = __builtin_ctzll(free);
+    else { // the n-th allowed way
+      uint32_t n = cm_get_random_uint32() % __builtin_popcountll(mask);
+      while(n--) mask &= mask - 1;
+      *w = __builtin_ctzll(mask);
     }
+    return 0;
   }
+  virtual void access(uint32_t s, uint32_t w) { used[s] |= 1ull << w; }
+  virtual void invalid(uint32_t s, uint32_t w) { used[s] &= ~(1ull << w); }
+
+  virtual void save(CheckpointWriter &ckpt) const { ckpt.write(used.data(), used.size() * sizeof(uint64_t)); }
+  virtual bool restore(CheckpointReader &ckpt) { return ckpt.read(used.data(), used.size() * sizeof(uint64_t)); }
 };
 
 #endif
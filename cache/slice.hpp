@@ -0,0 +1,139 @@
+#ifndef CM_CACHE_SLICE_HPP
+#define CM_CACHE_SLICE_HPP
+
+#include <cassert>
+#include <vector>
+#include <type_traits>
+
+#include "util/random.hpp"
+#include "util/checkpoint.hpp"
+#include "cache/coherence.hpp"
+
+/////////////////////////////////
+// Base class of slice mapping functions
+class SliceHashBase
+{
+public:
+  virtual ~SliceHashBase() {}
+  virtual uint32_t slice(uint64_t addr) = 0;
+
+  // checkpoint the seeds of keyed slice functions
+  virtual void save(CheckpointWriter &ckpt) const {}
+  virtual bool restore(CheckpointReader &ckpt) { return true; }
+};
+
+/////////////////////////////////
+// Interleave blocks among slices
+//   NS: number of slices, BlkOfst: block offset
+template<int NS, int BlkOfst>
+class SliceHashNorm : public SliceHashBase
+{
+public:
+  constexpr static uint32_t nslice = NS;
+  virtual uint32_t slice(uint64_t addr) { return (addr >> BlkOfst) % NS; }
+};
+
+/////////////////////////////////
+// Intel complex addressing (Maurice et al., RAID 2015)
+//   each bit of the slice id is the parity of the physical address bits selected by a mask
+//   NS: number of slices, a power of 2 no larger than 8, BlkOfst: block offset
+//   (the bits below BlkOfst are cleared, so all bytes of a block larger than 64B map to the same slice)
+template<int NS, int BlkOfst>
+class SliceHashIntel : public SliceHashBase
+{
+  static_assert(NS == 1 || NS == 2 || NS == 4 || NS == 8, "SliceHashIntel supports 1, 2, 4 or 8 slices");
+  constexpr static uint64_t masks[3] = {0x1b5f575440ull, 0x2eb5faa880ull, 0x3cccc93100ull};
+public:
+  constexpr static uint32_t nslice = NS;
+  virtual uint32_t slice(uint64_t addr) {
+    uint32_t rv = 0;
+    addr &= ~((1ull << BlkOfst) - 1);
+    for(int i=0; (1 << i) < NS; i++) rv |= __builtin_parityll(addr & masks[i]) << i;
+    return rv;
+  }
+};
+
+/////////////////////////////////
+// Keyed (randomized) slice mapping
+//   NS: number of slices, BlkOfst: block offset
+template<int NS, int BlkOfst>
+class SliceHashKeyed : public SliceHashBase
+{
+  CMHasher hasher;
+public:
+  constexpr static uint32_t nslice = NS;
+  virtual uint32_t slice(uint64_t addr) { return hasher(addr >> BlkOfst) % NS; }
+
+  void seed(uint64_t s) { hasher.seed(s); }
+
+  virtual void save(CheckpointWriter &ckpt) const { ckpt.put<uint64_t>(hasher.get_seed()); }
+  virtual bool restore(CheckpointReader &ckpt) {
+    hasher.seed(ckpt.get<uint64_t>());
+    return ckpt.good();
+  }
+};
+
+/////////////////////////////////
+// Slice dispatcher
+//   A coherence master standing for a sliced (shared) cache. Inner caches connect to the dispatcher
+//   as to a normal master, which registers them with every slice (so they get the same coherence id
+//   in all slices and can be probed by any slice). Acquire and writeback requests are routed to
+//   the slice selected by the slice mapping function SH; probes are sent by the slices directly.
+//   Being the only crossing point between an inner cache and the slices, the dispatcher is also
+//   where per-slice request queues would be inserted when slices run on their own threads.
+//   Coherence messages sent to a dispatcher are addressed to the slice of the block (get_id(addr)).
+template<typename SH,
+         typename = typename std::enable_if<std::is_base_of<SliceHashBase, SH>::value>::type> // SH <- SliceHashBase
+class SliceDispatcher : public CohMasterBase
+{
+protected:
+  const std::string name;
+  std::vector<CohMasterBase *> slices;
+  SH hasher;
+
+public:
+  SliceDispatcher(const std::string &name = "") : name(name) {}
+  virtual ~SliceDispatcher() {}
+
+  // add the inner port of a slice, slices must be added before connecting inner caches
+  void add_slice(CohMasterBase *s) { slices.push_back(s); }
+
+  virtual uint32_t connect(CohClientBase *c) {
+    assert(slices.size() == SH::nslice);
+    uint32_t id = slices[0]->connect(c);
+    for(uint32_t i=1; i<slices.size(); i++) {
+      auto sid = slices[i]->connect(c);
+      assert(sid == id); // all slices must be connected to the same inner caches in the same order
+    }
+    return id;
+  }
+
+  uint32_t get_slice(uint64_t addr) { return hasher.slice(addr); }
+
+  using CohMasterBase::get_id;
+  virtual uint32_t get_id(uint64_t addr) { return slices[hasher.slice(addr)]->get_id(); }
+
+  virtual void acquire_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
+    slices[hasher.slice(addr)]->acquire_resp(addr, data, cmd, delay);
+  }
+
+  virtual void writeback_resp(uint64_t addr, CMDataBase *data, uint32_t cmd, uint64_t *delay) {
+    slices[hasher.slice(addr)]->writeback_resp(addr, data, cmd, delay);
+  }
+
+  virtual void fetch_resp(uint64_t addr, CMDataBase *data, uint64_t *delay) {
+    slices[hasher.slice(addr)]->fetch_resp(addr, data, delay);
+  }
+
+  // checkpoint the slice mapping function
+  void save(CheckpointWriter &ckpt) const {
+    ckpt.put_string(name);
+    ckpt.put<uint32_t>(slices.size());
+    hasher.save(ckpt);
+  }
+  bool restore(CheckpointReader &ckpt) {
+    return ckpt.expect_string(name, "slice dispatcher") && ckpt.expect<uint32_t>(slices.size(), "number of slices") && hasher.restore(ckpt);
+  }
+};
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef CM_CACHE_VICTIM_HPP
+#define CM_CACHE_VICTIM_HPP
+
+#include <cassert>
+#include <vector>
+#include <unordered_map>
+
+#include "cache/cache.hpp"
+
+// Cache with a victim buffer
+// IW: index width, NW: number of ways, VW: number of victim entries
+// MT: metadata type, DT: data type (void if not in use)
+// IDX: indexer type, RPC: replacer type (of the main array)
+// EnMon: whether to enable monitoring
+//   arrays[0] is the set-associative main array and arrays[1] the fully associative victim array (LRU).
+//   A victim array entry is located as (1, s, w) where s is the original set of its block.
+//   A block replaced from the main array moves to the victim array: replace() returns the victim array
+//   entry leaving the cache, and the replaced block of the main array is swapped with the filled block
+//   when the fill is hooked.
+//   hit() finds blocks in the victim array without moving them, so that probes, flushes and writebacks
+//   handle them in place. A block read or written in the victim array is swapped with the replacement
+//   candidate of its set within the way mask of the requester (swap-on-hit) when the access is hooked,
+//   and later hooks of the same access (the exclusive hub moving the block inward) follow the block.
+//   Blocks keep their metadata when moving between arrays (tags remain relative to the original set)
+//   and the victim array is looked up by a hash map of block addresses.
+//   Way masks apply to the main array only, the victim array is shared by all partitions.
+template<int IW, int NW, int VW, typename MT, typename DT, typename IDX, typename RPC, typename DLY, bool EnMon>
+class CacheVictim : public CacheSkewed<IW, NW, 1, MT, DT, IDX, RPC, DLY, EnMon>
+{
+  typedef CacheSkewed<IW, NW, 1, MT, DT, IDX, RPC, DLY, EnMon> CacheT;
+  typedef CacheArrayNorm<0, VW, MT, DT> VictimT;
+
+protected:
+  std::unordered_map<uint64_t, uint32_t> vmap; // block address -> victim entry (validated by match)
+  std::vector<uint64_t> vaddr;  // block address of each victim entry
+  std::vector<uint32_t> vset;   // original set of each victim entry
+  std::vector<uint64_t> vstamp; // LRU stamp of each victim entry
+  uint64_t vclock;
+  bool pending;                 // a fill through the victim array is not hooked yet
+  uint32_t pending_s, pending_w, pending_v;
+  bool moved;                   // the block of moved_addr is swapped from victim entry moved_v to way moved_w
+  uint32_t moved_s, moved_w, moved_v;
+  uint64_t moved_addr;
+  uint64_t cnt_victim_hit;
+
+  VictimT *victim() const { return static_cast<VictimT *>(this->arrays[1]); }
+
+  // block address of addr in set s
+  static uint64_t block(uint64_t addr, uint32_t s) {
+    MT m;
+    m.MT::init(addr);
+    return m.MT::addr(s);
+  }
+
+  bool victim_lookup(uint64_t addr, uint32_t s, uint32_t *v) {
+    auto it = vmap.find(block(addr, s));
+    if(it == vmap.end() || vset[it->second] != s || !victim()->get_meta(0, it->second)->match(addr)) return false;
+    *v = it->second;
+    return true;
+  }
+
+  // a free victim entry or the LRU one
+  uint32_t victim_replace() {
+    uint32_t v = 0;
+    for(uint32_t i=0; i<VW; i++) {
+      if(!victim()->get_meta(0, i)->is_valid()) return i;
+      if(vstamp[i] < vstamp[v]) v = i;
+    }
+    return v;
+  }
+
+  // the block in victim entry v is no longer found by lookups
+  void victim_release(uint32_t v) {
+    auto it = vmap.find(vaddr[v]);
+    if(it != vmap.end() && it->second == v) vmap.erase(it);
+  }
+
+  // swap the blocks in way w of set s and in victim entry v
+  void swap(uint32_t s, uint32_t w, uint32_t v) {
+    MT *m = nullptr;
+    DT *d = nullptr;
+    this->array(0)->exchange(s, w, &m, &d);
+    victim()->exchange(0, v, &m, &d);
+    this->array(0)->exchange(s, w, &m, &d);
+
+    moved = false;
+    victim_release(v);
+    auto meta = victim()->get_meta(0, v);
+    vset[v] = s;
+    if(meta->is_valid()) {
+      vaddr[v] = meta->addr(s);
+      vmap[vaddr[v]] = v;
+    }
+    vstamp[v] = ++vclock;
+  }
+
+  // move a block filled through the victim array to the main array
+  void fill(uint32_t *ai, uint32_t *s, uint32_t *w) {
+    assert(pending && *w == pending_v);
+    swap(pending_s, pending_w, pending_v);
+    pending = false;
+    *ai = 0; *s = pending_s; *w = pending_w;
+  }
+
+  // swap-on-hit: move the block accessed in victim entry *w to the main array
+  void promote(uint64_t addr, uint32_t part, uint32_t *ai, uint32_t *s, uint32_t *w) {
+    uint32_t v = *w;
+    CacheT::replace(addr, ai, s, w, part); // the candidate within the way mask, *s is unchanged
+    swap(*s, *w, v);
+    moved = true; moved_s = *s; moved_w = *w; moved_v = v; moved_addr = block(addr, *s);
+    if(!this->owner.empty()) this->partition_fill(0, *s, *w); // owned by the requester
+    cnt_victim_hit++;
+  }
+
+  // follow a block moved by the last swap-on-hit
+  void relocate(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w) {
+    if(*ai == 1 && moved && *s == moved_s && *w == moved_v && block(addr, *s) == moved_addr) { *ai = 0; *w = moved_w; }
+  }
+
+  // report an event of a victim array entry to monitors and the delay estimator (the main replacer is not involved)
+  void victim_report(uint64_t addr, uint32_t s, uint32_t w, bool evict, bool probe, bool writeback, uint64_t *delay) {
+    if(this->fast) return;
+    if constexpr (EnMon) {
+      CM_PROFILE_SCOPE(this->profile, MONITOR);
+      if(evict) for(auto m:this->monitors) m->invalid(addr, 1, s, w);
+      if(probe) for(auto m:this->monitors) m->probe(addr, 1, s, w, evict, writeback);
+    }
+    if constexpr (!std::is_void<DLY>::value) if(delay) {
+      uint64_t d = *delay;
+      if(probe) this->timer->probe(addr, 1, s, w, writeback, delay);
+      else      this->timer->invalid(addr, 1, s, w, writeback, delay);
+      this->report_delay(*delay - d);
+    }
+  }
+
+public:
+  CacheVictim(std::string name = "")
+    : CacheT(name), vaddr(VW, 0), vset(VW, 0), vstamp(VW, 0), vclock(0), pending(false), moved(false), cnt_victim_hit(0)
+  {
+    this->arrays.push_back(new VictimT());
+  }
+
+  virtual ~CacheVictim() {}
+
+  virtual bool hit(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w) {
+    if(CacheT::hit(addr, ai, s, w)) return true;
+    *ai = 1;
+    *s = this->index(addr, 0);
+    return victim_lookup(addr, *s, w);
+  }
+
+  virtual void replace(uint64_t addr, uint32_t *ai, uint32_t *s, uint32_t *w, uint32_t part = 0) {
+    assert(!pending);
+    moved = false; // a new block
+    CacheT::replace(addr, ai, s, w, part);
+    if(!this->access(0, *s, *w)->is_valid()) return; // a free way in the main array
+    // the replaced block moves to the victim array, whose entry v leaves the cache
+    pending = true; pending_s = *s; pending_w = *w; pending_v = victim_replace();
+    *ai = 1; *s = vset[pending_v]; *w = pending_v;
+    victim_release(pending_v); // no longer found by probes, a clean block stays valid until overwritten by the fill
+  }
+
+  virtual void query_batch(const uint64_t *addr, size_t n, CMResidency *rv) {
+    CacheT::query_batch(addr, n, rv);
+    for(size_t i=0; i<n; i++)
+      if(rv[i].level < 0) {
+        uint32_t s = this->indexer.IDX::index(addr[i], 0), v;
+        if(victim_lookup(addr[i], s, &v)) { rv[i].level = 0; rv[i].ai = 1; rv[i].s = s; rv[i].w = v; }
+      }
+  }
+
+  virtual void hook_read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    relocate(addr, &ai, &s, &w);
+    if(ai == 1) {
+      if(pending && w == pending_v) fill(&ai, &s, &w);
+      else                          promote(addr, part, &ai, &s, &w);
+    }
+    CacheT::hook_read(addr, ai, s, w, hit, delay, part);
+  }
+
+  virtual void hook_write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit, uint64_t *delay, uint32_t part = 0) {
+    relocate(addr, &ai, &s, &w);
+    if(ai == 1) {
+      if(pending && w == pending_v) fill(&ai, &s, &w);
+      else                          promote(addr, part, &ai, &s, &w);
+    }
+    CacheT::hook_write(addr, ai, s, w, hit, delay, part);
+  }
+
+  virtual void hook_invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool writeback, uint64_t *delay) {
+    relocate(addr, &ai, &s, &w);
+    if(ai == 0) { CacheT::hook_invalid(addr, ai, s, w, writeback, delay); return; }
+    victim_release(w);
+    victim_report(addr, s, w, true, false, writeback, delay);
+  }
+
+  virtual void hook_probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback, uint64_t *delay) {
+    relocate(addr, &ai, &s, &w);
+    if(ai == 0) { CacheT::hook_probe(addr, ai, s, w, evict, writeback, delay); return; }
+    if(evict) victim_release(w);
+    victim_report(addr, s, w, evict, true, writeback, delay);
+  }
+
+  // the set of a victim entry is the original set of its block, the victim array has a single set
+  virtual CMMetadataBase *access(uint32_t ai, uint32_t s, uint32_t w) {
+    return this->arrays[ai]->get_meta(ai ? 0 : s, w);
+  }
+  virtual CMDataBase *get_data(uint32_t ai, uint32_t s, uint32_t w) {
+    return this->arrays[ai]->get_data(ai ? 0 : s, w);
+  }
+
+  uint64_t get_victim_hit() const { return cnt_victim_hit; }
+
+  virtual void save(CheckpointWriter &ckpt) const {
+    assert(!pending);
+    CacheT::save(ckpt);
+    ckpt.write(vset.data(), VW * sizeof(uint32_t));
+    ckpt.write(vstamp.data(), VW * sizeof(uint64_t));
+    ckpt.put<uint64_t>(vclock);
+  }
+
+  virtual bool restore(CheckpointReader &ckpt) {
+    if(!CacheT::restore(ckpt)) return false;
+    ckpt.read(vset.data(), VW * sizeof(uint32_t));
+    ckpt.read(vstamp.data(), VW * sizeof(uint64_t));
+    vclock = ckpt.get<uint64_t>();
+    vmap.clear();
+    for(uint32_t v=0; v<VW; v++) {
+      auto meta = victim()->get_meta(0, v);
+      if(meta->is_valid()) { vaddr[v] = meta->addr(vset[v]); vmap[vaddr[v]] = v; }
+    }
+    pending = false;
+    moved = false;
+    return ckpt.good();
+  }
+};
+
+#endif
@@ -29,6 +29,8 @@ void CodeGen::init() {
   decoders.push_back(new StatementTypeDef);
   decoders.push_back(new StatementCreate);
   decoders.push_back(new StatementConnect);
+  decoders.push_back(new StatementAttach);
+  decoders.push_back(new StatementDispatch);
 
   decoders.push_back(new StatementError); // always the final one
 
@@ -68,6 +70,12 @@ void CodeGen::emit_hpp(std::ofstream &file) {
   if(!space.empty()) file << "namespace " << space << " {\n" << std::endl;
   for(auto def:type_declarations) def->emit(file);
   for(auto e:entities) e->emit_declaration(file, true);
+  file << std::endl;
+  file << "extern void init();" << std::endl;
+  file << "extern void set_fast_forward(bool enable);" << std::endl;
+  file << "extern bool save_checkpoint(const std::string &fn);" << std::endl;
+  file << "extern bool restore_checkpoint(const std::string &fn);" << std::endl;
+  file << "extern void query_batch(const uint64_t *addr, size_t n, CMResidency *rv);" << std::endl;
   if(!space.empty()) file << "\n}" << std::endl;
 }
 
@@ -81,6 +89,15 @@ void CodeGen::emit_cpp(std::ofstream &file, const std::string& h) {
   file << "  // initialize entities" << std::endl;
   for(auto e:entities) e->emit_initialization(file);
   file << std::endl;
+  if(!dispatches.empty()) {
+    file << "  // add slices to dispatchers" << std::endl;
+    for(auto d:dispatches) {
+      auto slice = d.second.first;
+      file << "  " << d.first.first->name << "[" << d.first.second << "]->add_slice(";
+      file << slice->name << "[" << d.second.second << "]" << slice->etype->get_inner() << ");" << std::endl;
+    }
+    file << std::endl;
+  }
   file << "  // connect entities" << std::endl;
   for(auto c:connections) {
     auto client = c.first.first;
@@ -92,7 +109,86 @@ void CodeGen::emit_cpp(std::ofstream &file, const std::string& h) {
     file << manager->name << "[" << mi << "]" << manager->etype->get_inner() << "->connect(";
     file << client->name << "[" << ci << "]" << client->etype->get_outer() << "));" << std::endl;
   }
-  file << std::endl;  
+  file << std::endl;
+  if(!attachments.empty()) {
+    file << "  // attach monitors" << std::endl;
+    for(auto a:attachments) {
+      auto monitor = a.first.first;
+      auto target = a.second.first;
+      file << "  " << target->name << "[" << a.second.second << "]";
+      if(target->etype->comply("EpochMonitorBase")) file << "->add(";
+      else                                          file << "->attach_monitor(";
+      file << monitor->name << "[" << a.first.second << "]);" << std::endl;
+    }
+    file << std::endl;
+  }
+  file << "}" << std::endl;
+  file << std::endl;
+  file << "// fast-forward (functional warm-up): states and data evolve as in detailed mode without delay or monitoring" << std::endl;
+  file << "void set_fast_forward(bool enable) {" << std::endl;
+  for(auto e:entities)
+    if(e->etype->comply("CoherentCacheBase"))
+      file << "  for(auto c:" << e->name << ") c->set_fast_forward(enable);" << std::endl;
+  file << "}" << std::endl;
+
+  // checkpoint of caches, slice dispatchers and memories (in the order of creation) and the random generator
+  std::list<CacheEntity *> states;
+  for(auto e:entities)
+    if(e->etype->comply("CoherentCacheBase") || e->etype->comply("SliceDispatcher") || e->etype->comply("SimpleMemoryModel")) states.push_back(e);
+  file << std::endl;
+  file << "bool save_checkpoint(const std::string &fn) {" << std::endl;
+  file << "  CheckpointWriter ckpt(fn);" << std::endl;
+  file << "  ckpt.put_string(cm_get_random_state());" << std::endl;
+  for(auto e:states)
+    file << "  for(auto c:" << e->name << ") c->save(ckpt);" << std::endl;
+  file << "  return ckpt.close();" << std::endl;
+  file << "}" << std::endl;
+  file << std::endl;
+  file << "bool restore_checkpoint(const std::string &fn) {" << std::endl;
+  file << "  CheckpointReader ckpt(fn);" << std::endl;
+  file << "  if(!ckpt.good()) return false;" << std::endl;
+  file << "  auto state = ckpt.get_string();" << std::endl;
+  for(auto e:states)
+    file << "  for(auto c:" << e->name << ") if(!c->restore(ckpt)) return false;" << std::endl;
+  file << "  cm_set_random_state(state);" << std::endl;
+  file << "  return ckpt.good();" << std::endl;
+  file << "}" << std::endl;
+
+  // residency query, the level of a cache is its distance from the core interfaces in the connection graph:
+  //   caches without inner caches are level 0 and a cache is one level above its farthest inner cache,
+  //   where the slices of a dispatcher take the inner caches connected to the dispatcher
+  std::map<CacheEntity *, int> levels;
+  for(auto e:entities)
+    if(e->etype->comply("CoherentCacheBase")) levels[e] = 0;
+  int max_level = 0;
+  bool changed = true;
+  for(unsigned int round = 0; changed && round <= levels.size(); round++) { // relax until stable (bounded in case of a cycle)
+    changed = false;
+    for(auto c:connections) {
+      auto client = c.first.first, manager = c.second.first;
+      if(!levels.count(client)) continue;
+      std::list<CacheEntity *> targets;
+      if(levels.count(manager)) targets.push_back(manager);
+      for(auto d:dispatches) if(d.first.first == manager) targets.push_back(d.second.first);
+      for(auto t:targets)
+        if(levels[t] < levels[client] + 1) {
+          levels[t] = levels[client] + 1;
+          if(levels[t] > max_level) max_level = levels[t];
+          changed = true;
+        }
+    }
+  }
+  file << std::endl;
+  file << "void query_batch(const uint64_t *addr, size_t n, CMResidency *rv) {" << std::endl;
+  file << "  for(size_t i=0; i<n; i++) rv[i].level = -1;" << std::endl;
+  for(int level=0; level<=max_level; level++) {
+    unsigned int base = 0; // caches of a level are numbered in the order of declaration
+    for(auto e:entities)
+      if(levels.count(e) && levels[e] == level) {
+        file << "  cm_query_level(" << e->name << ", " << level << ", addr, n, rv, " << base << ");" << std::endl;
+        base += e->size;
+      }
+  }
   file << "}" << std::endl;
   if(!space.empty()) file << "\n}" << std::endl;
 }
@@ -223,6 +319,135 @@ bool StatementConnect::decode(const char* line) {
   return true;
 }
 
+StatementAttach::StatementAttach() : StatementBase(R_LS+"attach"+R_VAR+R_SI+"->"+R_VAR+R_RI+R_SE) {}
+
+bool StatementAttach::decode(const char* line) {
+  if(!match(line)) return false;
+
+  // get monitor
+  std::string monitor(cm[1]);
+  if(!entitydb.entities.count(monitor)) {
+    std::cerr << "[Decode] Fail to match `" << monitor << "' with a created entity." << std::endl;
+    return false;
+  }
+  auto monitor_entity = entitydb.entities[monitor];
+  if(!monitor_entity->etype->comply("MonitorBase")) {
+    std::cerr << "[Decode] `" << monitor << "' is not a monitor." << std::endl;
+    return false;
+  }
+
+  // get target, a coherent cache or an epoch monitor collecting PFC monitors
+  std::string target(cm[4]);
+  if(!entitydb.entities.count(target)) {
+    std::cerr << "[Decode] Fail to match `" << target << "' with a created entity." << std::endl;
+    return false;
+  }
+  auto target_entity = entitydb.entities[target];
+  if(target_entity->etype->comply("EpochMonitorBase")) {
+    if(!monitor_entity->etype->comply("PFCMonitor")) {
+      std::cerr << "[Decode] only PFC monitors can be collected by the epoch monitor `" << target << "'." << std::endl;
+      return false;
+    }
+  } else if(!target_entity->etype->comply("CoherentCacheBase")) {
+    std::cerr << "[Decode] `" << target << "' is neither a cache nor an epoch monitor." << std::endl;
+    return false;
+  }
+
+  // target range
+  int r0 = target_entity->size-1, r1 = 0;
+  if(cm[5].length()) { // has start range
+    if(!codegendb.parse_int(cm[6], r0)) return false;
+    if(cm[7].length()) { if(!codegendb.parse_int(cm[8], r1)) return false; }
+    else r1 = r0;
+    if(r0 < r1 || r1 < 0 || r0 >= target_entity->size) {
+      std::cerr << "[Decode] " << cm[5] << " out of the valid range [" << target_entity->size-1 << ":0] of " << target << std::endl;
+      return false;
+    }
+  }
+  int ntarget = r0 - r1 + 1;
+
+  // monitor index
+  if(cm[2].length()) { // a single monitor attached to all targets
+    int mi;
+    if(!codegendb.parse_int(cm[3], mi)) return false;
+    if(mi < 0 || mi >= monitor_entity->size) {
+      std::cerr << "[Decode] " << cm[2] << " out of the valid range [" << monitor_entity->size-1 << ":0] of " << monitor << std::endl;
+      return false;
+    }
+    for(int i=r1; i<=r0; i++)
+      codegendb.attachments.push_back(std::make_pair(std::make_pair(monitor_entity, mi), std::make_pair(target_entity, i)));
+  } else if(monitor_entity->size == 1) { // one to all
+    for(int i=r1; i<=r0; i++)
+      codegendb.attachments.push_back(std::make_pair(std::make_pair(monitor_entity, 0), std::make_pair(target_entity, i)));
+  } else if(ntarget == 1) { // all to one
+    for(int i=0; i<monitor_entity->size; i++)
+      codegendb.attachments.push_back(std::make_pair(std::make_pair(monitor_entity, i), std::make_pair(target_entity, r0)));
+  } else if(ntarget == monitor_entity->size) { // one to one
+    for(int i=0; i<ntarget; i++)
+      codegendb.attachments.push_back(std::make_pair(std::make_pair(monitor_entity, i), std::make_pair(target_entity, r1+i)));
+  } else {
+    std::cerr << "[Decode] cannot attach " << monitor_entity->size << " monitors to " << ntarget << " targets." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+StatementDispatch::StatementDispatch() : StatementBase(R_LS+"dispatch"+R_VAR+R_SI+"->"+R_VAR+R_RI+R_SE) {}
+
+bool StatementDispatch::decode(const char* line) {
+  if(!match(line)) return false;
+
+  // get dispatcher
+  std::string dispatcher(cm[1]);
+  if(!entitydb.entities.count(dispatcher)) {
+    std::cerr << "[Decode] Fail to match `" << dispatcher << "' with a created entity." << std::endl;
+    return false;
+  }
+  auto dispatcher_entity = entitydb.entities[dispatcher];
+  if(!dispatcher_entity->etype->comply("SliceDispatcher")) {
+    std::cerr << "[Decode] `" << dispatcher << "' is not a slice dispatcher." << std::endl;
+    return false;
+  }
+
+  // dispatcher index
+  int di = 0;
+  if(cm[2].length() && !codegendb.parse_int(cm[3], di)) return false;
+  if(di < 0 || di >= dispatcher_entity->size) {
+    std::cerr << "[Decode] " << cm[2] << " out of the valid range [" << dispatcher_entity->size-1 << ":0] of " << dispatcher << std::endl;
+    return false;
+  }
+
+  // get slices, coherent caches added in the order of their indices
+  std::string slice(cm[4]);
+  if(!entitydb.entities.count(slice)) {
+    std::cerr << "[Decode] Fail to match `" << slice << "' with a created entity." << std::endl;
+    return false;
+  }
+  auto slice_entity = entitydb.entities[slice];
+  if(!slice_entity->etype->comply("CoherentCacheBase")) {
+    std::cerr << "[Decode] `" << slice << "' is not a cache." << std::endl;
+    return false;
+  }
+
+  // slice range
+  int r0 = slice_entity->size-1, r1 = 0;
+  if(cm[5].length()) { // has start range
+    if(!codegendb.parse_int(cm[6], r0)) return false;
+    if(cm[7].length()) { if(!codegendb.parse_int(cm[8], r1)) return false; }
+    else r1 = r0;
+    if(r0 < r1 || r1 < 0 || r0 >= slice_entity->size) {
+      std::cerr << "[Decode] " << cm[5] << " out of the valid range [" << slice_entity->size-1 << ":0] of " << slice << std::endl;
+      return false;
+    }
+  }
+
+  for(int i=r1; i<=r0; i++)
+    codegendb.dispatches.push_back(std::make_pair(std::make_pair(dispatcher_entity, di), std::make_pair(slice_entity, i)));
+
+  return true;
+}
+
 StatementError::StatementError() :  StatementBase("") {}
 
 bool StatementError::decode(const char* line) {
@@ -38,6 +38,8 @@ struct CodeGen
   std::list<CacheEntity *> entities;
   std::map<std::string, int> consts;
   std::list<std::pair<std::pair<CacheEntity *, int>, std::pair<CacheEntity *, int> > > connections;
+  std::list<std::pair<std::pair<CacheEntity *, int>, std::pair<CacheEntity *, int> > > attachments; // (monitor, cache or epoch monitor)
+  std::list<std::pair<std::pair<CacheEntity *, int>, std::pair<CacheEntity *, int> > > dispatches;  // (slice dispatcher, slice)
 
   bool debug;
 
@@ -74,6 +76,8 @@ GEN_STATEMENT(Const);
 GEN_STATEMENT(TypeDef);
 GEN_STATEMENT(Create);
 GEN_STATEMENT(Connect);
+GEN_STATEMENT(Attach);
+GEN_STATEMENT(Dispatch);
 GEN_STATEMENT(Error);
 
 #undef GEN_STATEMENT
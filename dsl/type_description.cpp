@@ -5,6 +5,9 @@ DescriptionDB::DescriptionDB() {
   Description *descriptor;
   // adding types with no template parameters
   descriptor = new TypeData64B(); add("Data64B", descriptor); descriptor->emit_header();
+  descriptor = new TypePFCMonitor("PFCMonitor"); add("PFCMonitor", descriptor); descriptor->emit_header();
+  descriptor = new TypeCoherenceMonitor("CoherenceMonitor"); add("CoherenceMonitor", descriptor); descriptor->emit_header();
+  descriptor = new TypePartitionMonitor("PartitionMonitor"); add("PartitionMonitor", descriptor); descriptor->emit_header();
 }
 
 DescriptionDB::~DescriptionDB() {
@@ -15,25 +18,46 @@ bool DescriptionDB::create(const std::string &type_name, const std::string &base
   Description *descriptor = nullptr;
   if(base_name == "MetadataMSI")           descriptor = new TypeMetadataMSI(type_name);
   if(base_name == "Data64B")               descriptor = new TypeData64B(type_name);
+  if(base_name == "DataBlock")             descriptor = new TypeDataBlock(type_name);
+  if(base_name == "DataSectored")          descriptor = new TypeDataSectored(type_name);
   if(base_name == "CacheArrayNorm")        descriptor = new TypeCacheArrayNorm(type_name);
   if(base_name == "CacheSkewed")           descriptor = new TypeCacheSkewed(type_name);
   if(base_name == "CacheNorm")             descriptor = new TypeCacheNorm(type_name);
+  if(base_name == "CacheVictim")           descriptor = new TypeCacheVictim(type_name);
+  if(base_name == "CacheMirage")           descriptor = new TypeCacheMirage(type_name);
+  if(base_name == "CacheCompressed")       descriptor = new TypeCacheCompressed(type_name);
+  if(base_name == "CompressNone")          descriptor = new TypeCompressFuncBase(type_name, base_name);
+  if(base_name == "CompressBDI")           descriptor = new TypeCompressFuncBase(type_name, base_name);
+  if(base_name == "CompressFPC")           descriptor = new TypeCompressFuncBase(type_name, base_name);
   if(base_name == "OuterPortMSIUncached")  descriptor = new TypeOuterPortMSIUncached(type_name);
   if(base_name == "OuterPortMSI")          descriptor = new TypeOuterPortMSI(type_name);
+  if(base_name == "OuterPortMSIExclusive") descriptor = new TypeOuterPortMSIExclusive(type_name);
   if(base_name == "InnerPortMSIUncached")  descriptor = new TypeInnerPortMSIUncached(type_name);
   if(base_name == "InnerPortMSIBroadcast") descriptor = new TypeInnerPortMSIBroadcast(type_name);
+  if(base_name == "InnerPortMSINonInclusive") descriptor = new TypeInnerPortMSINonInclusive(type_name);
+  if(base_name == "InnerPortMSIExclusive") descriptor = new TypeInnerPortMSIExclusive(type_name);
+  if(base_name == "InnerPortMSISnoopFilter") descriptor = new TypeInnerPortMSISnoopFilter(type_name);
   if(base_name == "CoreInterfaceMSI")      descriptor = new TypeCoreInterfaceMSI(type_name);
   if(base_name == "CoherentCacheNorm")     descriptor = new TypeCoherentCacheNorm(type_name);
   if(base_name == "CoherentL1CacheNorm")   descriptor = new TypeCoherentL1CacheNorm(type_name);
   if(base_name == "SimpleMemoryModel")     descriptor = new TypeSimpleMemoryModel(type_name);
+  if(base_name == "SliceHashNorm")         descriptor = new TypeSliceHashNorm(type_name);
+  if(base_name == "SliceHashIntel")        descriptor = new TypeSliceHashIntel(type_name);
+  if(base_name == "SliceHashKeyed")        descriptor = new TypeSliceHashKeyed(type_name);
+  if(base_name == "SliceDispatcher")       descriptor = new TypeSliceDispatcher(type_name);
   if(base_name == "IndexNorm")             descriptor = new TypeIndexNorm(type_name);
   if(base_name == "IndexSkewed")           descriptor = new TypeIndexSkewed(type_name);
   if(base_name == "IndexRandom")           descriptor = new TypeIndexRandom(type_name);
   if(base_name == "ReplaceFIFO")           descriptor = new TypeReplaceFIFO(type_name);
   if(base_name == "ReplaceLRU")            descriptor = new TypeReplaceLRU(type_name);
+  if(base_name == "ReplaceRandom")         descriptor = new TypeReplaceRandom(type_name);
   if(base_name == "DelayL1")               descriptor = new TypeDelayL1(type_name);
   if(base_name == "DelayCoherentCache")    descriptor = new TypeDelayCoherentCache(type_name);
   if(base_name == "DelayMemory")           descriptor = new TypeDelayMemory(type_name);
+  if(base_name == "PFCMonitor")            descriptor = new TypePFCMonitor(type_name);
+  if(base_name == "CoherenceMonitor")      descriptor = new TypeCoherenceMonitor(type_name);
+  if(base_name == "PartitionMonitor")      descriptor = new TypePartitionMonitor(type_name);
+  if(base_name == "EpochMonitor")          descriptor = new TypeEpochMonitor(type_name);
 
   if(nullptr == descriptor) {
     std::cerr << "[Decode] Fail to match `" << base_name << "' with a known base type." << std::endl;
@@ -77,6 +101,42 @@ void TypeData64B::emit(std::ofstream &file) {
     file << "typedef " << tname << " " << this->name << ";" << std::endl;
 }
 
+bool TypeDataBlock::set(std::list<std::string> &values) {
+  if(values.size() != 1) {
+    std::cerr << "[Mismatch] " << tname << " needs 1 parameters!" << std::endl;
+    return false;
+  }
+  if(!codegendb.parse_int(values.front(), N)) return false;
+  if(N != 32 && N != 64 && N != 128) {
+    std::cerr << "[Mismatch] " << tname << " supports blocks of 32, 64 or 128 bytes!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void TypeDataBlock::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << N << "> " << this->name << ";" << std::endl;
+}
+
+bool TypeDataSectored::set(std::list<std::string> &values) {
+  if(values.size() != 2) {
+    std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, N)) return false; it++;
+  if(!codegendb.parse_int(*it, NS)) return false; it++;
+  if((N != 32 && N != 64 && N != 128) || NS < 1 || (N/8) % NS != 0) {
+    std::cerr << "[Mismatch] " << tname << " supports blocks of 32, 64 or 128 bytes divided into sectors of whole 64b words!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void TypeDataSectored::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << N << "," << NS << "> " << this->name << ";" << std::endl;
+}
+
 bool TypeCacheArrayNorm::set(std::list<std::string> &values) {
   if(values.size() != 4) {
     std::cerr << "[Mismatch] " << tname << " needs 4 parameters!" << std::endl;
@@ -95,8 +155,8 @@ void TypeCacheArrayNorm::emit(std::ofstream &file) {
 }
 
 bool TypeCacheSkewed::set(std::list<std::string> &values) {
-  if(values.size() != 9) {
-    std::cerr << "[Mismatch] " << tname << " needs 9 parameters!" << std::endl;
+  if(values.size() != 9 && values.size() != 10) {
+    std::cerr << "[Mismatch] " << tname << " needs 9 parameters (and an optional EnSparse)!" << std::endl;
     return false;
   }
   auto it = values.begin();
@@ -109,16 +169,17 @@ bool TypeCacheSkewed::set(std::list<std::string> &values) {
   RPC = *it; if(!this->check(tname, "RPC", *it, "ReplaceFuncBase", false)) return false; it++;
   DLY = *it; if(!this->check(tname, "DLY", *it, "DelayBase", true)) return false; it++;
   if(!codegendb.parse_bool(*it, EnMon)) return false; it++;
+  EnSparse = false; if(it != values.end() && !codegendb.parse_bool(*it, EnSparse)) return false;
   return true;
 }
  
 void TypeCacheSkewed::emit(std::ofstream &file) {
-  file << "typedef " << tname << "<" << IW << "," << NW << "," << P << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << DLY << "," << EnMon << "> " << this->name << ";" << std::endl;
+  file << "typedef " << tname << "<" << IW << "," << NW << "," << P << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << DLY << "," << EnMon << "," << EnSparse << "> " << this->name << ";" << std::endl;
 }
 
 bool TypeCacheNorm::set(std::list<std::string> &values) {
-  if(values.size() != 8) {
-    std::cerr << "[Mismatch] " << tname << " needs 8 parameters!" << std::endl;
+  if(values.size() != 8 && values.size() != 9) {
+    std::cerr << "[Mismatch] " << tname << " needs 8 parameters (and an optional EnSparse)!" << std::endl;
     return false;
   }
   auto it = values.begin();
@@ -130,13 +191,100 @@ bool TypeCacheNorm::set(std::list<std::string> &values) {
   RPC = *it; if(!this->check(tname, "RPC", *it, "ReplaceFuncBase", false)) return false; it++;
   DLY = *it; if(!this->check(tname, "DLY", *it, "DelayBase", true)) return false; it++;
   if(!codegendb.parse_bool(*it, EnMon)) return false; it++;
+  EnSparse = false; if(it != values.end() && !codegendb.parse_bool(*it, EnSparse)) return false;
   return true;
 }
  
 void TypeCacheNorm::emit(std::ofstream &file) {
-  file << "typedef " << tname << "<" << IW << "," << NW << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << DLY << "," << EnMon << "> " << this->name << ";" << std::endl;
+  file << "typedef " << tname << "<" << IW << "," << NW << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << DLY << "," << EnMon << "," << EnSparse << "> " << this->name << ";" << std::endl;
+}
+
+bool TypeCacheVictim::set(std::list<std::string> &values) {
+  if(values.size() != 9) {
+    std::cerr << "[Mismatch] " << tname << " needs 9 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, IW)) return false; it++;
+  if(!codegendb.parse_int(*it, NW)) return false; it++;
+  if(!codegendb.parse_int(*it, VW)) return false; it++;
+  MT  = *it; if(!this->check(tname, "MT", *it, "CMMetadataBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "CMDataBase", true)) return false; it++;
+  IDX = *it; if(!this->check(tname, "IDX", *it, "IndexFuncBase", false)) return false; it++;
+  RPC = *it; if(!this->check(tname, "RPC", *it, "ReplaceFuncBase", false)) return false; it++;
+  DLY = *it; if(!this->check(tname, "DLY", *it, "DelayBase", true)) return false; it++;
+  if(!codegendb.parse_bool(*it, EnMon)) return false; it++;
+  return true;
+}
+
+void TypeCacheVictim::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << IW << "," << NW << "," << VW << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << DLY << "," << EnMon << "> " << this->name << ";" << std::endl;
+}
+
+void TypeCacheVictim::emit_header() { codegendb.add_header("cache/victim.hpp"); }
+
+bool TypeCacheMirage::set(std::list<std::string> &values) {
+  if(values.size() != 10) {
+    std::cerr << "[Mismatch] " << tname << " needs 10 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, IW)) return false; it++;
+  if(!codegendb.parse_int(*it, NW)) return false; it++;
+  if(!codegendb.parse_int(*it, EW)) return false; it++;
+  if(!codegendb.parse_int(*it, P)) return false; it++;
+  MT  = *it; if(!this->check(tname, "MT", *it, "CMMetadataBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "CMDataBase", true)) return false; it++;
+  IDX = *it; if(!this->check(tname, "IDX", *it, "IndexFuncBase", false)) return false; it++;
+  RPC = *it; if(!this->check(tname, "RPC", *it, "ReplaceFuncBase", false)) return false; it++;
+  DLY = *it; if(!this->check(tname, "DLY", *it, "DelayBase", true)) return false; it++;
+  if(!codegendb.parse_bool(*it, EnMon)) return false; it++;
+  return true;
+}
+
+void TypeCacheMirage::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << IW << "," << NW << "," << EW << "," << P << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << DLY << "," << EnMon << "> " << this->name << ";" << std::endl;
+}
+
+void TypeCacheMirage::emit_header() { codegendb.add_header("cache/mirage.hpp"); }
+
+bool TypeCacheCompressed::set(std::list<std::string> &values) {
+  if(values.size() != 10) {
+    std::cerr << "[Mismatch] " << tname << " needs 10 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, IW)) return false; it++;
+  if(!codegendb.parse_int(*it, NW)) return false; it++;
+  if(!codegendb.parse_int(*it, EW)) return false; it++;
+  MT  = *it; if(!this->check(tname, "MT", *it, "CMMetadataBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "DataBlock", true)) return false; it++;
+  IDX = *it; if(!this->check(tname, "IDX", *it, "IndexFuncBase", false)) return false; it++;
+  RPC = *it; if(!this->check(tname, "RPC", *it, "ReplaceFuncBase", false)) return false; it++;
+  CMP = *it; if(!this->check(tname, "CMP", *it, "CompressFuncBase", false)) return false; it++;
+  DLY = *it; if(!this->check(tname, "DLY", *it, "DelayBase", true)) return false; it++;
+  if(!codegendb.parse_bool(*it, EnMon)) return false; it++;
+  return true;
 }
 
+void TypeCacheCompressed::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << IW << "," << NW << "," << EW << "," << MT << "," << DT << "," << IDX << "," << RPC << "," << CMP << "," << DLY << "," << EnMon << "> " << this->name << ";" << std::endl;
+}
+
+void TypeCacheCompressed::emit_header() { codegendb.add_header("cache/compress.hpp"); }
+
+bool TypeCompressFuncBase::set(std::list<std::string> &values) {
+  if(values.empty()) return true;
+  std::cerr << "[No Paramater] " << tname << " supports no parameter!" << std::endl;
+  return false;
+}
+
+void TypeCompressFuncBase::emit(std::ofstream &file) {
+  file << "typedef " << tname << " " << this->name << ";" << std::endl;
+}
+
+void TypeCompressFuncBase::emit_header() { codegendb.add_header("cache/compress.hpp"); }
+
 bool TypeOuterPortMSIUncached::set(std::list<std::string> &values) {
   if(values.size() != 2) {
     std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
@@ -171,6 +319,23 @@ void TypeOuterPortMSI::emit(std::ofstream &file) {
 
 void TypeOuterPortMSI::emit_header() { codegendb.add_header("cache/msi.hpp"); }
 
+bool TypeOuterPortMSIExclusive::set(std::list<std::string> &values) {
+  if(values.size() != 2) {
+    std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  MT  = *it; if(!this->check(tname, "MT", *it, "MetadataMSIBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "CMDataBase", true)) return false; it++;
+  return true;
+}
+
+void TypeOuterPortMSIExclusive::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << MT << "," << DT << "> " << this->name << ";" << std::endl;
+}
+
+void TypeOuterPortMSIExclusive::emit_header() { codegendb.add_header("cache/msi.hpp"); }
+
 bool TypeInnerPortMSIUncached::set(std::list<std::string> &values) {
   if(values.size() != 3) {
     std::cerr << "[Mismatch] " << tname << " needs 3 parameters!" << std::endl;
@@ -207,6 +372,64 @@ void TypeInnerPortMSIBroadcast::emit(std::ofstream &file) {
 
 void TypeInnerPortMSIBroadcast::emit_header() { codegendb.add_header("cache/msi.hpp"); }
 
+bool TypeInnerPortMSINonInclusive::set(std::list<std::string> &values) {
+  if(values.size() != 3) {
+    std::cerr << "[Mismatch] " << tname << " needs 3 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  MT  = *it; if(!this->check(tname, "MT", *it, "MetadataMSIBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "CMDataBase", true)) return false; it++;
+  if(!codegendb.parse_bool(*it, isLLC)) return false; it++;
+  return true;
+}
+
+void TypeInnerPortMSINonInclusive::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << MT << "," << DT << "," << isLLC << "> " << this->name << ";" << std::endl;
+}
+
+void TypeInnerPortMSINonInclusive::emit_header() { codegendb.add_header("cache/msi.hpp"); }
+
+bool TypeInnerPortMSIExclusive::set(std::list<std::string> &values) {
+  if(values.size() != 3) {
+    std::cerr << "[Mismatch] " << tname << " needs 3 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  MT  = *it; if(!this->check(tname, "MT", *it, "MetadataMSIBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "CMDataBase", true)) return false; it++;
+  if(!codegendb.parse_bool(*it, isLLC)) return false; it++;
+  return true;
+}
+
+void TypeInnerPortMSIExclusive::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << MT << "," << DT << "," << isLLC << "> " << this->name << ";" << std::endl;
+}
+
+void TypeInnerPortMSIExclusive::emit_header() { codegendb.add_header("cache/msi.hpp"); }
+
+bool TypeInnerPortMSISnoopFilter::set(std::list<std::string> &values) {
+  if(values.size() != 7) {
+    std::cerr << "[Mismatch] " << tname << " needs 7 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  MT  = *it; if(!this->check(tname, "MT", *it, "MetadataMSIBase", false)) return false; it++;
+  DT  = *it; if(!this->check(tname, "DT", *it, "CMDataBase", true)) return false; it++;
+  if(!codegendb.parse_bool(*it, isLLC)) return false; it++;
+  if(!codegendb.parse_int(*it, IW)) return false; it++;
+  if(!codegendb.parse_int(*it, NW)) return false; it++;
+  if(!codegendb.parse_int(*it, IOfst)) return false; it++;
+  if(!codegendb.parse_bool(*it, nonInclusive)) return false; it++;
+  return true;
+}
+
+void TypeInnerPortMSISnoopFilter::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << MT << "," << DT << "," << isLLC << "," << IW << "," << NW << "," << IOfst << "," << nonInclusive << "> " << this->name << ";" << std::endl;
+}
+
+void TypeInnerPortMSISnoopFilter::emit_header() { codegendb.add_header("cache/msi.hpp"); }
+
 bool TypeCoreInterfaceMSI::set(std::list<std::string> &values) {
   if(values.size() != 4) {
     std::cerr << "[Mismatch] " << tname << " needs 4 parameters!" << std::endl;
@@ -277,6 +500,73 @@ void TypeCoherentL1CacheNorm::emit(std::ofstream &file) {
   file << "typedef " << tname << "<" << CacheT << "," << OuterT << "," << CoreT << "> " << this->name << ";" << std::endl;
 }
 
+void TypeSliceHashBase::emit_header() { codegendb.add_header("cache/slice.hpp"); }
+
+bool TypeSliceHashNorm::set(std::list<std::string> &values) {
+  if(values.size() != 2) {
+    std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, NS)) return false; it++;
+  if(!codegendb.parse_int(*it, BlkOfst)) return false; it++;
+  return true;
+}
+
+void TypeSliceHashNorm::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << NS << "," << BlkOfst << "> " << this->name << ";" << std::endl;
+}
+
+bool TypeSliceHashIntel::set(std::list<std::string> &values) {
+  if(values.size() != 2) {
+    std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, NS)) return false; it++;
+  if(!codegendb.parse_int(*it, BlkOfst)) return false; it++;
+  if(NS != 1 && NS != 2 && NS != 4 && NS != 8) {
+    std::cerr << "[Range] " << tname << " supports 1, 2, 4 or 8 slices!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void TypeSliceHashIntel::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << NS << "," << BlkOfst << "> " << this->name << ";" << std::endl;
+}
+
+bool TypeSliceHashKeyed::set(std::list<std::string> &values) {
+  if(values.size() != 2) {
+    std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, NS)) return false; it++;
+  if(!codegendb.parse_int(*it, BlkOfst)) return false; it++;
+  return true;
+}
+
+void TypeSliceHashKeyed::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << NS << "," << BlkOfst << "> " << this->name << ";" << std::endl;
+}
+
+bool TypeSliceDispatcher::set(std::list<std::string> &values) {
+  if(values.size() != 1) {
+    std::cerr << "[Mismatch] " << tname << " needs 1 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  SH = *it; if(!this->check(tname, "SH", *it, "SliceHashBase", false)) return false; it++;
+  return true;
+}
+
+void TypeSliceDispatcher::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << SH << "> " << this->name << ";" << std::endl;
+}
+
+void TypeSliceDispatcher::emit_header() { codegendb.add_header("cache/slice.hpp"); }
+
 void TypeIndexFuncBase::emit_header() { codegendb.add_header("cache/index.hpp"); }
 
 bool TypeIndexNorm::set(std::list<std::string> &values) {
@@ -357,6 +647,21 @@ void TypeReplaceLRU::emit(std::ofstream &file) {
   file << "typedef " << tname << "<" << IW << "," << NW << "> " << this->name << ";" << std::endl;
 }  
 
+bool TypeReplaceRandom::set(std::list<std::string> &values) {
+  if(values.size() != 2) {
+    std::cerr << "[Mismatch] " << tname << " needs 2 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, IW)) return false; it++;
+  if(!codegendb.parse_int(*it, NW)) return false; it++;
+  return true;
+}
+
+void TypeReplaceRandom::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << IW << "," << NW << "> " << this->name << ";" << std::endl;
+}
+
 void TypeDelayBase::emit_header() { codegendb.add_header("cache/delay.hpp"); }
 
 bool TypeDelayL1::set(std::list<std::string> &values) {
@@ -404,3 +709,61 @@ bool TypeDelayMemory::set(std::list<std::string> &values) {
 void TypeDelayMemory::emit(std::ofstream &file) {
   file << "typedef " << tname << "<" << dtran << "> " << this->name << ";" << std::endl;
 }
+
+void TypeMonitorBase::emit_header() { codegendb.add_header("util/monitor.hpp"); }
+
+bool TypePFCMonitor::set(std::list<std::string> &values) {
+  if(values.empty()) return true;
+  std::cerr << "[No Paramater] " << tname << " supports no parameter!" << std::endl;
+  return false;
+}
+
+void TypePFCMonitor::emit(std::ofstream &file) {
+  if(this->name != tname)
+    file << "typedef " << tname << " " << this->name << ";" << std::endl;
+}
+
+bool TypeCoherenceMonitor::set(std::list<std::string> &values) {
+  if(values.empty()) return true;
+  std::cerr << "[No Paramater] " << tname << " supports no parameter!" << std::endl;
+  return false;
+}
+
+void TypeCoherenceMonitor::emit(std::ofstream &file) {
+  if(this->name != tname)
+    file << "typedef " << tname << " " << this->name << ";" << std::endl;
+}
+
+bool TypePartitionMonitor::set(std::list<std::string> &values) {
+  if(values.empty()) return true;
+  std::cerr << "[No Paramater] " << tname << " supports no parameter!" << std::endl;
+  return false;
+}
+
+void TypePartitionMonitor::emit(std::ofstream &file) {
+  if(this->name != tname)
+    file << "typedef " << tname << " " << this->name << ";" << std::endl;
+}
+
+bool TypeEpochMonitor::set(std::list<std::string> &values) {
+  if(values.size() != 4) {
+    std::cerr << "[Mismatch] " << tname << " needs 4 parameters!" << std::endl;
+    return false;
+  }
+  auto it = values.begin();
+  if(!codegendb.parse_int(*it, period)) return false; it++;
+  if(!codegendb.parse_bool(*it, cycle)) return false; it++;
+  if(!codegendb.parse_int(*it, format)) return false; it++;
+  if(!codegendb.parse_int(*it, ring)) return false; it++;
+  if(period <= 0 || ring <= 0 || format < 0 || format > 2) {
+    std::cerr << "[Range] " << tname << " needs a positive period and ring size, and a format of 0 (csv), 1 (json) or 2 (binary)!" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void TypeEpochMonitor::emit(std::ofstream &file) {
+  file << "typedef " << tname << "<" << period << "," << cycle << "," << format << "," << ring << "> " << this->name << ";" << std::endl;
+}
+
+void TypeEpochMonitor::emit_header() { codegendb.add_header("util/epoch.hpp"); }
@@ -93,8 +93,28 @@ class TypeData64B : public TypeCMDataBase
 {
   const std::string tname;
 public:
-  TypeData64B(const std::string &name) : TypeCMDataBase(name), tname("Data64B") { types.insert("Data64B"); }
-  TypeData64B() : TypeCMDataBase(""), tname("Data64B") { types.insert("Data64B"); }
+  TypeData64B(const std::string &name) : TypeCMDataBase(name), tname("Data64B") { types.insert("Data64B"); types.insert("DataBlock"); }
+  TypeData64B() : TypeCMDataBase(""), tname("Data64B") { types.insert("Data64B"); types.insert("DataBlock"); }
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeDataBlock : public TypeCMDataBase
+{
+  const std::string tname;
+  int N;
+public:
+  TypeDataBlock(const std::string &name) : TypeCMDataBase(name), tname("DataBlock") { types.insert("DataBlock"); }
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeDataSectored : public TypeCMDataBase
+{
+  const std::string tname;
+  int N, NS;
+public:
+  TypeDataSectored(const std::string &name) : TypeCMDataBase(name), tname("DataSectored") { types.insert("DataSectored"); }
   virtual bool set(std::list<std::string> &values);
   virtual void emit(std::ofstream &file);
 };
@@ -123,7 +143,7 @@ public: TypeCacheBase(const std::string &name) : Description(name) { types.inser
 
 class TypeCacheSkewed : public TypeCacheBase
 {
-  int IW, NW, P; std::string MT, DT, IDX, RPC, DLY; bool EnMon;
+  int IW, NW, P; std::string MT, DT, IDX, RPC, DLY; bool EnMon, EnSparse;
   const std::string tname;
 public:
   TypeCacheSkewed(const std::string &name) : TypeCacheBase(name), tname("CacheSkewed") {}
@@ -133,7 +153,7 @@ public:
 
 class TypeCacheNorm : public TypeCacheBase
 {
-  int IW, NW; std::string MT, DT, IDX, RPC, DLY; bool EnMon;
+  int IW, NW; std::string MT, DT, IDX, RPC, DLY; bool EnMon, EnSparse;
   const std::string tname;
 public:
   TypeCacheNorm(const std::string &name) : TypeCacheBase(name), tname("CacheNorm") {}
@@ -141,6 +161,50 @@ public:
   virtual void emit(std::ofstream &file);
 };
 
+class TypeCacheVictim : public TypeCacheBase
+{
+  int IW, NW, VW; std::string MT, DT, IDX, RPC, DLY; bool EnMon;
+  const std::string tname;
+public:
+  TypeCacheVictim(const std::string &name) : TypeCacheBase(name), tname("CacheVictim") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
+class TypeCacheMirage : public TypeCacheBase
+{
+  int IW, NW, EW, P; std::string MT, DT, IDX, RPC, DLY; bool EnMon;
+  const std::string tname;
+public:
+  TypeCacheMirage(const std::string &name) : TypeCacheBase(name), tname("CacheMirage") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
+class TypeCacheCompressed : public TypeCacheBase
+{
+  int IW, NW, EW; std::string MT, DT, IDX, RPC, CMP, DLY; bool EnMon;
+  const std::string tname;
+public:
+  TypeCacheCompressed(const std::string &name) : TypeCacheBase(name), tname("CacheCompressed") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
+////////////////////////////// Compressibility Function ///////////////////////////////////////////////
+
+class TypeCompressFuncBase : public Description {
+  const std::string tname;
+public:
+  TypeCompressFuncBase(const std::string &name, const std::string &tname) : Description(name), tname(tname) { types.insert("CompressFuncBase"); }
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
 ////////////////////////////// Coherent Cache ///////////////////////////////////////////////
 
 class TypeOuterCohPortBase : public Description {
@@ -167,6 +231,16 @@ public:
   virtual void emit_header();
 };
 
+class TypeOuterPortMSIExclusive : public TypeOuterCohPortBase {
+  std::string MT, DT;
+  const std::string tname;
+public:
+  TypeOuterPortMSIExclusive(const std::string &name) : TypeOuterCohPortBase(name), tname("OuterPortMSIExclusive") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
 class TypeInnerCohPortBase : public Description {
 public: TypeInnerCohPortBase(const std::string &name) : Description(name) { types.insert("InnerCohPortBase"); types.insert("CohMasterBase"); }
 };
@@ -193,6 +267,39 @@ public:
   virtual void emit_header();
 };
 
+class TypeInnerPortMSINonInclusive : public TypeInnerCohPortBase
+{
+  std::string MT, DT; bool isLLC;
+  const std::string tname;
+public:
+  TypeInnerPortMSINonInclusive(const std::string &name) : TypeInnerCohPortBase(name), tname("InnerPortMSINonInclusive") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
+class TypeInnerPortMSIExclusive : public TypeInnerCohPortBase
+{
+  std::string MT, DT; bool isLLC;
+  const std::string tname;
+public:
+  TypeInnerPortMSIExclusive(const std::string &name) : TypeInnerCohPortBase(name), tname("InnerPortMSIExclusive") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
+class TypeInnerPortMSISnoopFilter : public TypeInnerCohPortBase
+{
+  std::string MT, DT; bool isLLC; int IW, NW, IOfst; bool nonInclusive;
+  const std::string tname;
+public:
+  TypeInnerPortMSISnoopFilter(const std::string &name) : TypeInnerCohPortBase(name), tname("InnerPortMSISnoopFilter") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
 class TypeCoreInterfaceBase : public TypeInnerCohPortBase {
 public: TypeCoreInterfaceBase(const std::string &name) : TypeInnerCohPortBase(name) { types.insert("CoreInterfaceBase"); }
 };
@@ -246,12 +353,61 @@ class TypeSimpleMemoryModel : public TypeCoreInterfaceBase
   std::string DT, DLY;
   const std::string tname;
 public:
-  TypeSimpleMemoryModel(const std::string &name) : TypeCoreInterfaceBase(name), tname("SimpleMemoryModel") {}
+  TypeSimpleMemoryModel(const std::string &name) : TypeCoreInterfaceBase(name), tname("SimpleMemoryModel") { types.insert("SimpleMemoryModel"); }
   virtual bool set(std::list<std::string> &values);  
   virtual void emit(std::ofstream &file);
   virtual void emit_header();
 };
 
+////////////////////////////// Slice ///////////////////////////////////////////////
+
+class TypeSliceHashBase : public Description {
+public:
+  TypeSliceHashBase(const std::string &name) : Description(name) { types.insert("SliceHashBase"); }
+  virtual void emit_header();
+};
+
+class TypeSliceHashNorm : public TypeSliceHashBase
+{
+  int NS, BlkOfst;
+  const std::string tname;
+public:
+  TypeSliceHashNorm(const std::string &name) : TypeSliceHashBase(name), tname("SliceHashNorm") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeSliceHashIntel : public TypeSliceHashBase
+{
+  int NS, BlkOfst;
+  const std::string tname;
+public:
+  TypeSliceHashIntel(const std::string &name) : TypeSliceHashBase(name), tname("SliceHashIntel") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeSliceHashKeyed : public TypeSliceHashBase
+{
+  int NS, BlkOfst;
+  const std::string tname;
+public:
+  TypeSliceHashKeyed(const std::string &name) : TypeSliceHashBase(name), tname("SliceHashKeyed") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeSliceDispatcher : public TypeInnerCohPortBase
+{
+  std::string SH;
+  const std::string tname;
+public:
+  TypeSliceDispatcher(const std::string &name) : TypeInnerCohPortBase(name), tname("SliceDispatcher") { types.insert("SliceDispatcher"); }
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
 ////////////////////////////// Index ///////////////////////////////////////////////
 
 class TypeIndexFuncBase : public Description {
@@ -319,6 +475,16 @@ public:
   virtual void emit(std::ofstream &file);
 };
 
+class TypeReplaceRandom : public TypeReplaceFuncBase
+{
+  int IW, NW;
+  const std::string tname;
+public:
+  TypeReplaceRandom(const std::string &name) : TypeReplaceFuncBase(name), tname("ReplaceRandom") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
 ////////////////////////////// Delay ///////////////////////////////////////////////
 
 class TypeDelayBase : public Description {
@@ -357,4 +523,50 @@ public:
   virtual void emit(std::ofstream &file);
 };
 
+////////////////////////////// Monitor ///////////////////////////////////////////////
+
+class TypeMonitorBase : public Description {
+public:
+  TypeMonitorBase(const std::string &name) : Description(name) { types.insert("MonitorBase"); }
+  virtual void emit_header();
+};
+
+class TypePFCMonitor : public TypeMonitorBase
+{
+  const std::string tname;
+public:
+  TypePFCMonitor(const std::string &name) : TypeMonitorBase(name), tname("PFCMonitor") { types.insert("PFCMonitor"); }
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeCoherenceMonitor : public TypeMonitorBase
+{
+  const std::string tname;
+public:
+  TypeCoherenceMonitor(const std::string &name) : TypeMonitorBase(name), tname("CoherenceMonitor") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypePartitionMonitor : public TypeMonitorBase
+{
+  const std::string tname;
+public:
+  TypePartitionMonitor(const std::string &name) : TypeMonitorBase(name), tname("PartitionMonitor") {}
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+};
+
+class TypeEpochMonitor : public TypeMonitorBase
+{
+  int period, format, ring; bool cycle;
+  const std::string tname;
+public:
+  TypeEpochMonitor(const std::string &name) : TypeMonitorBase(name), tname("EpochMonitor") { types.insert("EpochMonitorBase"); }
+  virtual bool set(std::list<std::string> &values);
+  virtual void emit(std::ofstream &file);
+  virtual void emit_header();
+};
+
 #endif
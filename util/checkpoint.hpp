@@ -0,0 +1,175 @@
+#ifndef CM_UTIL_CHECKPOINT_HPP
+#define CM_UTIL_CHECKPOINT_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Checkpoint file
+//   header: uint32_t magic ("FCCK"), version
+//   body:   the sections written by save() of each component in the order of the hierarchy,
+//           a component records its geometry and checks it on restore()
+//   Page-sized blocks (memory pages) are aligned to 4KB in the file, so that they can be
+//   mapped copy-on-write on restore instead of being copied.
+//   As restored pages keep referring to the file, a checkpoint is written to a temporary file
+//   and renamed over the target when closed, which leaves the old file intact for the mappings
+//   (do not overwrite a checkpoint in place while a hierarchy restored from it is alive).
+
+class CheckpointWriter
+{
+protected:
+  const std::string fn, tmp; // the target and the temporary file being written
+  FILE *file;
+  uint64_t pos;
+  bool ok;
+
+public:
+  constexpr static uint32_t magic   = 0x4b434346; // "FCCK"
+  constexpr static uint32_t version = 2;
+
+  CheckpointWriter(const std::string &fn)
+    : fn(fn), tmp(fn + ".tmp." + std::to_string(getpid())), file(fopen(tmp.c_str(), "wb")), pos(0), ok(file != nullptr) {
+    if(!ok) std::cerr << "[Checkpoint] Fail to open `" << tmp << "' for write." << std::endl;
+    put(magic);
+    put(version);
+  }
+
+  ~CheckpointWriter() { close(); }
+
+  bool good() const { return ok; }
+
+  // finish the checkpoint and replace the target file, return whether the checkpoint is complete
+  bool close() {
+    if(!file) return ok;
+    if(fclose(file) != 0) ok = false;
+    file = nullptr;
+    if(ok && rename(tmp.c_str(), fn.c_str()) != 0) {
+      std::cerr << "[Checkpoint] Fail to replace `" << fn << "'." << std::endl;
+      ok = false;
+    }
+    if(!ok) unlink(tmp.c_str());
+    return ok;
+  }
+
+  void write(const void *p, size_t n) {
+    if(!ok) return;
+    if(fwrite(p, 1, n, file) != n) ok = false;
+    pos += n;
+  }
+
+  template<typename T> void put(const T &v) { write(&v, sizeof(T)); }
+
+  void put_string(const std::string &s) {
+    put<uint64_t>(s.size());
+    write(s.data(), s.size());
+  }
+
+  // pad the file to a multiple of a bytes
+  void align(uint64_t a) {
+    static const char zero[4096] = {0};
+    uint64_t pad = (a - pos % a) % a;
+    while(pad) { uint64_t n = pad < 4096 ? pad : 4096; write(zero, n); pad -= n; }
+  }
+};
+
+class CheckpointReader
+{
+protected:
+  int fd;
+  const char *base;   // the whole file mapped read-only
+  uint64_t size, pos;
+  bool ok;
+
+public:
+  CheckpointReader(const std::string &fn) : fd(open(fn.c_str(), O_RDONLY)), base(nullptr), size(0), pos(0), ok(false) {
+    struct stat st;
+    if(fd < 0 || fstat(fd, &st) != 0) {
+      std::cerr << "[Checkpoint] Fail to open `" << fn << "' for read." << std::endl;
+      return;
+    }
+    size = st.st_size;
+    void *p = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if(p == MAP_FAILED) {
+      std::cerr << "[Checkpoint] Fail to map `" << fn << "'." << std::endl;
+      return;
+    }
+    base = static_cast<const char *>(p);
+    ok = true;
+    if(!expect(CheckpointWriter::magic, "magic number") || !expect(CheckpointWriter::version, "version"))
+      std::cerr << "[Checkpoint] `" << fn << "' is not a checkpoint of this version." << std::endl;
+  }
+
+  ~CheckpointReader() {
+    if(base) munmap(const_cast<char *>(base), size);
+    if(fd >= 0) close(fd);
+  }
+
+  bool good() const { return ok; }
+
+  bool read(void *p, size_t n) {
+    if(!ok || pos + n > size) { ok = false; return false; }
+    memcpy(p, base + pos, n);
+    pos += n;
+    return true;
+  }
+
+  template<typename T> T get() {
+    T v{};
+    read(&v, sizeof(T));
+    return v;
+  }
+
+  std::string get_string() {
+    uint64_t n = get<uint64_t>();
+    if(!ok || pos + n > size) { ok = false; return std::string(); }
+    std::string s(base + pos, n);
+    pos += n;
+    return s;
+  }
+
+  // read a value and check it against the expected one
+  template<typename T> bool expect(const T &v, const std::string &what) {
+    T r = get<T>();
+    if(ok && r != v) {
+      std::cerr << "[Checkpoint] Mismatched " << what << "." << std::endl;
+      ok = false;
+    }
+    return ok;
+  }
+
+  bool expect_string(const std::string &s, const std::string &what) {
+    std::string r = get_string();
+    if(ok && r != s) {
+      std::cerr << "[Checkpoint] Mismatched " << what << ": `" << r << "' while `" << s << "' is expected." << std::endl;
+      ok = false;
+    }
+    return ok;
+  }
+
+  void align(uint64_t a) { pos += (a - pos % a) % a; }
+
+  // map n bytes at the current (page aligned) position copy-on-write, nullptr if impossible
+  void *map(size_t n) {
+    if(!ok || pos + n > size) { ok = false; return nullptr; }
+    void *p = mmap(nullptr, n, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, pos);
+    if(p == MAP_FAILED) return nullptr;
+    pos += n;
+    return p;
+  }
+
+  // pointer to n bytes at the current position (valid while the reader is alive)
+  const void *peek(size_t n) {
+    if(!ok || pos + n > size) { ok = false; return nullptr; }
+    const void *p = base + pos;
+    pos += n;
+    return p;
+  }
+};
+
+#endif
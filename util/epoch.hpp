@@ -0,0 +1,182 @@
+#ifndef CM_UTIL_EPOCH_HPP
+#define CM_UTIL_EPOCH_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include "util/monitor.hpp"
+
+// Epoch (interval) statistics
+//   Every `period' accesses (or delay cycles) the counters of all registered PFCMonitors are
+//   snapshotted into a preallocated ring. A background writer thread streams the snapshots to
+//   <name>.csv, <name>.jsonl or <name>.bin so that the simulation never waits for file I/O
+//   (unless the ring is full).
+//   The epoch clock counts the read/write events of the caches the monitor is attached to,
+//   or, when epochs are measured in delay cycles, the delay charged by the timers of these caches
+//   (reported through delay(), requires a delay estimator) plus any cycles reported by advance().
+class EpochMonitorBase : public MonitorBase
+{
+public:
+  constexpr static int FMT_CSV    = 0;
+  constexpr static int FMT_JSON   = 1; // JSON lines
+  constexpr static int FMT_BINARY = 2;
+  constexpr static int NCNT       = 5; // words per counter: access, access_write, miss, miss_write, invalid
+
+protected:
+  const uint64_t period;    // length of an epoch
+  const bool cycle;         // epochs measured in delay cycles rather than accesses
+  const int format;
+  const size_t ring_size;   // number of records in the ring
+
+  std::vector<PFCMonitor *> counters;
+  std::vector<uint64_t> ring;          // records of [epoch, time, NCNT words per counter]
+  size_t width;                        // words per record
+  std::atomic<uint64_t> head, tail;    // produced and written records
+  uint64_t epoch, time, next, last;    // current epoch, epoch clock, time of the next and the last snapshot
+  bool active;
+
+  FILE *file;
+  std::thread writer;
+  std::atomic<bool> running;
+
+  void snapshot() {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    while(h - tail.load(std::memory_order_acquire) >= ring_size) std::this_thread::yield(); // ring full
+    uint64_t *r = ring.data() + (h % ring_size) * width;
+    r[0] = epoch++; r[1] = last = time;
+    for(size_t i=0; i<counters.size(); i++) {
+      auto c = counters[i];
+      uint64_t *v = r + 2 + i*NCNT;
+      v[0] = c->get_access(); v[1] = c->get_access_write();
+      v[2] = c->get_miss(); v[3] = c->get_miss_write(); v[4] = c->get_invalid();
+    }
+    head.store(h+1, std::memory_order_release);
+  }
+
+  void tick(uint64_t t) {
+    time += t;
+    if(time >= next) {
+      snapshot();
+      next = time - (time % period) + period;
+    }
+  }
+
+  void write_header() {
+    if(format == FMT_CSV) {
+      const char *fields[NCNT] = {"access", "access_write", "miss", "miss_write", "invalid"};
+      fprintf(file, "epoch,time");
+      for(auto c:counters) for(int f=0; f<NCNT; f++) fprintf(file, ",%s.%s", c->get_name().c_str(), fields[f]);
+      fprintf(file, "\n");
+    } else if(format == FMT_BINARY) {
+      // magic, version, number of counters, counter names (length prefixed), then raw records
+      uint32_t hdr[3] = {0x50454346, 1, (uint32_t)counters.size()}; // "FCEP"
+      fwrite(hdr, sizeof(hdr), 1, file);
+      for(auto c:counters) {
+        uint32_t len = c->get_name().size();
+        fwrite(&len, sizeof(len), 1, file);
+        fwrite(c->get_name().data(), 1, len, file);
+      }
+    }
+  }
+
+  void write_record(const uint64_t *r) {
+    if(format == FMT_CSV) {
+      fprintf(file, "%lu,%lu", r[0], r[1]);
+      for(size_t i=2; i<width; i++) fprintf(file, ",%lu", r[i]);
+      fprintf(file, "\n");
+    } else if(format == FMT_JSON) {
+      fprintf(file, "{\"epoch\":%lu,\"time\":%lu", r[0], r[1]);
+      for(size_t i=0; i<counters.size(); i++) {
+        const uint64_t *v = r + 2 + i*NCNT;
+        fprintf(file, ",\"%s\":{\"access\":%lu,\"access_write\":%lu,\"miss\":%lu,\"miss_write\":%lu,\"invalid\":%lu}",
+                counters[i]->get_name().c_str(), v[0], v[1], v[2], v[3], v[4]);
+      }
+      fprintf(file, "}\n");
+    } else
+      fwrite(r, sizeof(uint64_t), width, file);
+  }
+
+  void write_loop() {
+    while(true) {
+      uint64_t t = tail.load(std::memory_order_relaxed);
+      if(t < head.load(std::memory_order_acquire)) {
+        write_record(ring.data() + (t % ring_size) * width);
+        tail.store(t+1, std::memory_order_release);
+      } else if(running.load(std::memory_order_acquire))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      else
+        break;
+    }
+    fflush(file);
+  }
+
+public:
+  EpochMonitorBase(const std::string &name, uint64_t period, bool cycle, int format, size_t ring_size)
+    : MonitorBase(name), period(period), cycle(cycle), format(format), ring_size(ring_size), width(2),
+      head(0), tail(0), epoch(0), time(0), next(period), last(0), active(false), file(nullptr), running(false) {}
+
+  virtual ~EpochMonitorBase() { stop(); }
+
+  // register the counters to be snapshotted, must be done before start()
+  void add(PFCMonitor *m) { counters.push_back(m); }
+
+  // report extra delay cycles (e.g. from a driver), only used when epochs are measured in cycles
+  void advance(uint64_t cycles) { if(active && cycle) tick(cycles); }
+
+  virtual bool attach(uint64_t cache_id) { return true; }
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit)  { if(active && !cycle) tick(1); }
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) { if(active && !cycle) tick(1); }
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) {}
+  virtual void delay(uint64_t cycles) { if(active && cycle) tick(cycles); }
+
+  virtual void start() {
+    if(running) { active = true; return; }
+    width = 2 + counters.size() * NCNT;
+    ring.assign(ring_size * width, 0);
+    const char *ext[3] = {".csv", ".jsonl", ".bin"};
+    file = fopen((name + ext[format]).c_str(), format == FMT_BINARY ? "wb" : "w");
+    if(!file) {
+      fprintf(stderr, "[Epoch] Fail to open `%s%s' for write, epoch statistics are disabled.\n", name.c_str(), ext[format]);
+      return;
+    }
+    write_header();
+    running = true;
+    writer = std::thread(&EpochMonitorBase::write_loop, this);
+    active = true;
+  }
+
+  // snapshot the last partial epoch, drain the ring and close the file
+  virtual void stop() {
+    active = false;
+    if(!running) return;
+    if(time != last) snapshot();
+    running = false;
+    writer.join();
+    fclose(file);
+    file = nullptr;
+  }
+
+  virtual void pause() { active = false; }
+  virtual void resume() { active = running; }
+  virtual void reset() {
+    epoch = 0; time = 0; next = period; last = 0;
+  }
+
+  uint64_t get_epoch() const { return epoch; }
+  bool is_running() const { return running; }
+};
+
+// epoch monitor configured at compile time (as generated from the DSL)
+//   Period: epoch length, Cycle: measured in delay cycles, Format: EpochMonitorBase::FMT_*, RingSize: records in the ring
+template<uint64_t Period, bool Cycle, int Format, int RingSize>
+class EpochMonitor : public EpochMonitorBase
+{
+public:
+  EpochMonitor(const std::string &name = "epoch") : EpochMonitorBase(name, Period, Cycle, Format, RingSize) {}
+  virtual ~EpochMonitor() {}
+};
+
+#endif
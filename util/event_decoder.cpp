@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include "util/event_trace.hpp"
+
+// print a binary event trace recorded by EventTraceWriter in the global event order
+//   usage: event-decoder <trace file> [cache id]
+int main(int argc, char *argv[]) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s <trace file> [cache id]\n", argv[0]);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[1], "rb");
+  if(!file) {
+    fprintf(stderr, "[Error] fail to open trace file %s\n", argv[1]);
+    return 1;
+  }
+
+  uint32_t hdr[3];
+  if(fread(hdr, sizeof(hdr), 1, file) != 1 || hdr[0] != 0x56454346 || hdr[1] != 2 || hdr[2] != sizeof(EventRecord)) {
+    fprintf(stderr, "[Error] %s is not an event trace (or of an incompatible version)\n", argv[1]);
+    fclose(file);
+    return 1;
+  }
+
+  bool filter = argc > 2;
+  uint32_t cache = filter ? strtoul(argv[2], nullptr, 0) : 0;
+  std::vector<EventRecord> events;
+  EventRecord r;
+  while(fread(&r, sizeof(r), 1, file) == 1)
+    if(!filter || r.cache == cache) events.push_back(r);
+  fclose(file);
+
+  std::sort(events.begin(), events.end(), [](const EventRecord &a, const EventRecord &b) { return a.seq < b.seq; });
+
+  const char *type[4] = {"read", "write", "invalid", "probe"};
+  printf("seq,cache,event,addr,ai,s,w,hit,evict,writeback,delay\n");
+  for(auto &e:events)
+    printf("%lu,%u,%s,0x%016lx,%u,%u,%u,%d,%d,%d,%u\n", e.seq, e.cache, e.type() < 4 ? type[e.type()] : "unknown",
+           e.addr, e.ai, e.s, e.w, (e.flags() & EventRecord::HIT) != 0, (e.flags() & EventRecord::EVICT) != 0,
+           (e.flags() & EventRecord::WRITEBACK) != 0, e.delay);
+  return 0;
+}
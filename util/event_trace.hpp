@@ -0,0 +1,195 @@
+#ifndef CM_UTIL_EVENT_TRACE_HPP
+#define CM_UTIL_EVENT_TRACE_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include "util/monitor.hpp"
+
+// Binary event trace
+//   Every hook event (read, write, invalid, probe) of a cache is recorded by an EventTraceMonitor
+//   into its own single-producer single-consumer ring. An EventTraceWriter thread drains the rings
+//   of all its monitors asynchronously into one binary file:
+//     header: uint32_t magic ("FCEV"), version, sizeof(EventRecord)
+//     body:   EventRecord, in batches per cache; sort by seq to restore the global order
+//   Use the event-decoder tool (make event-decoder) to print a trace.
+
+struct EventRecord
+{
+  constexpr static uint8_t READ    = 0;
+  constexpr static uint8_t WRITE   = 1;
+  constexpr static uint8_t INVALID = 2; // also reported before an evicting probe
+  constexpr static uint8_t PROBE   = 3;
+
+  constexpr static uint8_t HIT       = 0x10; // flags, kept in the upper half of kind
+  constexpr static uint8_t EVICT     = 0x20;
+  constexpr static uint8_t WRITEBACK = 0x40;
+
+  uint64_t seq;    // global sequence number (across all caches of the writer)
+  uint64_t addr;
+  uint32_t s;
+  uint32_t delay;  // delay charged by the timer of the cache for this event
+  uint32_t cache;  // cache id (random ids use up to 31 bits)
+  uint16_t w;
+  uint8_t  ai;
+  uint8_t  kind;   // type | flags
+
+  uint8_t type()  const { return kind & 0x0f; }
+  uint8_t flags() const { return kind & 0xf0; }
+};
+
+static_assert(sizeof(EventRecord) == 32, "EventRecord is expected to be 32 bytes");
+
+class EventTraceMonitor;
+
+class EventTraceWriter
+{
+  friend class EventTraceMonitor;
+
+protected:
+  const std::string fn;
+  std::vector<EventTraceMonitor *> monitors;
+  std::atomic<uint64_t> seq;
+  FILE *file;
+  std::thread writer;
+  std::atomic<bool> running;
+
+  void write_loop();
+
+public:
+  EventTraceWriter(const std::string &fn) : fn(fn), seq(0), file(nullptr), running(false) {}
+  virtual ~EventTraceWriter() { stop(); }
+
+  // open the trace file and start the writer thread, all monitors must be created before
+  bool start() {
+    if(running) return true;
+    file = fopen(fn.c_str(), "wb");
+    if(!file) return false;
+    uint32_t hdr[3] = {0x56454346, 2, sizeof(EventRecord)}; // "FCEV"
+    fwrite(hdr, sizeof(hdr), 1, file);
+    running = true;
+    writer = std::thread(&EventTraceWriter::write_loop, this);
+    return true;
+  }
+
+  // drain all rings and close the file, call after the monitors are stopped (or paused)
+  void stop() {
+    if(!running) return;
+    running = false;
+    writer.join();
+    fclose(file);
+    file = nullptr;
+  }
+
+  uint64_t get_events() const { return seq.load(std::memory_order_relaxed); }
+};
+
+// per-cache event recorder (attach one instance per cache)
+class EventTraceMonitor : public MonitorBase
+{
+  friend class EventTraceWriter;
+
+protected:
+  EventTraceWriter *writer;
+  std::vector<EventRecord> ring;
+  const uint64_t mask;
+  std::atomic<uint64_t> head, tail;  // published and written records
+  bool staged;                       // the record at head is being filled (delay is not yet known)
+  uint32_t cache_id;
+  bool attached;
+  bool active;
+
+  static uint64_t round_up(uint64_t n) { uint64_t r = 1; while(r < n) r <<= 1; return r; }
+
+  // publish the staged record (if any) and return the next free slot
+  EventRecord *next_slot() {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if(staged) head.store(++h, std::memory_order_release);
+    while(h - tail.load(std::memory_order_acquire) >= ring.size()) std::this_thread::yield(); // ring full
+    staged = true;
+    return &ring[h & mask];
+  }
+
+  void publish() {
+    if(!staged) return;
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    staged = false;
+  }
+
+  void record(uint8_t type, uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, uint8_t flags) {
+    EventRecord *r = next_slot();
+    r->seq = writer->seq.fetch_add(1, std::memory_order_relaxed);
+    r->addr = addr; r->s = s; r->delay = 0;
+    r->cache = cache_id; r->w = w; r->ai = ai;
+    r->kind = type | flags;
+  }
+
+  // write all published records to file, called by the writer thread
+  bool drain(FILE *file) {
+    uint64_t t = tail.load(std::memory_order_relaxed), h = head.load(std::memory_order_acquire);
+    if(t == h) return false;
+    while(t < h) {
+      uint64_t i = t & mask, n = std::min<uint64_t>(h - t, ring.size() - i);
+      fwrite(&ring[i], sizeof(EventRecord), n, file);
+      t += n;
+    }
+    tail.store(t, std::memory_order_release);
+    return true;
+  }
+
+public:
+  EventTraceMonitor(EventTraceWriter *writer, size_t ring_size = 1ul << 16, const std::string &name = "")
+    : MonitorBase(name), writer(writer), ring(round_up(ring_size)), mask(round_up(ring_size) - 1),
+      head(0), tail(0), staged(false), cache_id(0), attached(false), active(false)
+  {
+    writer->monitors.push_back(this);
+  }
+  virtual ~EventTraceMonitor() {}
+
+  // a ring records a single cache
+  virtual bool attach(uint64_t id) {
+    if(attached) return id == cache_id;
+    cache_id = id; attached = true;
+    return true;
+  }
+
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {
+    if(active) record(EventRecord::READ, addr, ai, s, w, hit ? EventRecord::HIT : 0);
+  }
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {
+    if(active) record(EventRecord::WRITE, addr, ai, s, w, hit ? EventRecord::HIT : 0);
+  }
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) {
+    if(active) record(EventRecord::INVALID, addr, ai, s, w, 0);
+  }
+  virtual void probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback) {
+    if(active) record(EventRecord::PROBE, addr, ai, s, w, EventRecord::HIT | (evict ? EventRecord::EVICT : 0) | (writeback ? EventRecord::WRITEBACK : 0));
+  }
+  virtual void delay(uint64_t cycles) {
+    if(active && staged) ring[head.load(std::memory_order_relaxed) & mask].delay += cycles;
+  }
+
+  virtual void start()  { active = true; }
+  virtual void stop()   { active = false; publish(); }
+  virtual void pause()  { active = false; publish(); }
+  virtual void resume() { active = true; }
+  virtual void reset()  { active = false; publish(); }
+};
+
+inline void EventTraceWriter::write_loop() {
+  while(true) {
+    bool r = running.load(std::memory_order_acquire); // read before draining to not miss the last records
+    bool busy = false;
+    for(auto m:monitors) busy |= m->drain(file);
+    if(busy) continue;
+    if(!r) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  fflush(file);
+}
+
+#endif
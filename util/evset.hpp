@@ -0,0 +1,125 @@
+#ifndef CM_UTIL_EVSET_HPP
+#define CM_UTIL_EVSET_HPP
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "util/random.hpp"
+#include "cache/coherence.hpp"
+
+// Eviction-set discovery
+//   An attacker issues accesses through a core interface. Whether a set of addresses evicts a
+//   target is decided as an attacker would: access the target, access the set (repeat times),
+//   then time a probe of the target against a threshold (calibrate() derives one).
+//   The target and the set are accessed in tight batches without delay estimation; when a
+//   set_fast_forward function is provided (e.g. the generated set_fast_forward()), the batches
+//   also run in fast-forward mode, which leaves the same cache state and keeps the batches out of
+//   the monitors (it does not make them faster), and only probes are detailed.
+//   Reduction algorithms:
+//   - group testing:    split the set into groups, drop a group whenever the rest still evicts
+//   - conflict testing: drop every single address whenever the rest still evicts
+class EvictionSetEngine
+{
+protected:
+  CoreInterfaceBase *core;
+  uint64_t threshold;     // probe delay above which the target is considered evicted
+  const int repeat;       // times the set is accessed in a test
+  std::function<void(bool)> set_fast_forward;
+  uint64_t cnt_test, cnt_access;
+
+  void batch(const std::vector<uint64_t> &addrs, const std::vector<bool> *skip = nullptr) {
+    if(set_fast_forward) set_fast_forward(true);
+    for(int r=0; r<repeat; r++)
+      for(size_t i=0; i<addrs.size(); i++)
+        if(!skip || !(*skip)[i]) { core->read(addrs[i], nullptr); cnt_access++; }
+    if(set_fast_forward) set_fast_forward(false);
+  }
+
+  uint64_t probe(uint64_t addr) {
+    uint64_t delay = 0;
+    core->read(addr, &delay);
+    cnt_access++;
+    return delay;
+  }
+
+  // whether the set (without the skipped addresses) evicts the target
+  bool evicts(uint64_t target, const std::vector<uint64_t> &set, const std::vector<bool> *skip) {
+    cnt_test++;
+    batch(std::vector<uint64_t>(1, target));
+    batch(set, skip);
+    return probe(target) > threshold;
+  }
+
+public:
+  EvictionSetEngine(CoreInterfaceBase *core, uint64_t threshold = 0, int repeat = 1, std::function<void(bool)> set_fast_forward = nullptr)
+    : core(core), threshold(threshold), repeat(repeat), set_fast_forward(set_fast_forward), cnt_test(0), cnt_access(0) {}
+  virtual ~EvictionSetEngine() {}
+
+  // set the threshold between the probe delay of a cached block and that of a fresh block
+  //   addr: an address never accessed before
+  uint64_t calibrate(uint64_t addr) {
+    uint64_t miss = probe(addr);
+    uint64_t hit = probe(addr);
+    threshold = (hit + miss) / 2;
+    return threshold;
+  }
+
+  // n random addresses in [base, base+range) sharing the page offset of the target
+  //   as chosen by an attacker without knowledge of physical addresses; this also maps them to the
+  //   L1 set of the target, so that a set larger than the L1 associativity always reaches the LLC
+  std::vector<uint64_t> candidates(size_t n, uint64_t target, uint64_t base, uint64_t range, int page_offset = 12) {
+    std::vector<uint64_t> set(n);
+    uint64_t mask = (1ull << page_offset) - 1;
+    for(auto &a:set) a = ((base + cm_get_random_uint64() % range) & ~mask) | (target & mask);
+    return set;
+  }
+
+  bool test(uint64_t target, const std::vector<uint64_t> &set) { return evicts(target, set, nullptr); }
+
+  // group testing, reduce the set to no more than size addresses
+  // return false if the set does not evict the target or no group can be removed
+  bool reduce_group(uint64_t target, std::vector<uint64_t> &set, size_t size, uint32_t groups) {
+    if(!test(target, set)) return false;
+    std::vector<bool> skip;
+    while(set.size() > size) {
+      uint32_t ng = std::min<size_t>(groups, set.size());
+      bool found = false;
+      for(uint32_t g=0; g<ng && !found; g++) {
+        // group g: [g*n/ng, (g+1)*n/ng)
+        size_t b = g * set.size() / ng, e = (g+1) * set.size() / ng;
+        skip.assign(set.size(), false);
+        std::fill(skip.begin()+b, skip.begin()+e, true);
+        if(evicts(target, set, &skip)) {
+          set.erase(set.begin()+b, set.begin()+e);
+          found = true;
+        }
+      }
+      if(!found) return false;
+    }
+    return true;
+  }
+
+  // conflict testing, keep only the addresses necessary for the eviction
+  // return false if the set does not evict the target
+  bool reduce_conflict(uint64_t target, std::vector<uint64_t> &set) {
+    if(!test(target, set)) return false;
+    std::vector<bool> skip(set.size(), false);
+    for(size_t i=set.size(); i>0; i--) {
+      skip[i-1] = true;
+      if(!evicts(target, set, &skip)) skip[i-1] = false; // necessary, keep it
+    }
+    std::vector<uint64_t> rv;
+    for(size_t i=0; i<set.size(); i++) if(!skip[i]) rv.push_back(set[i]);
+    set.swap(rv);
+    return true;
+  }
+
+  uint64_t get_threshold() const { return threshold; }
+  uint64_t get_tests() const { return cnt_test; }
+  uint64_t get_accesses() const { return cnt_access; }
+  void reset_stats() { cnt_test = 0; cnt_access = 0; }
+};
+
+#endif
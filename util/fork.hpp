@@ -0,0 +1,150 @@
+#ifndef CM_UTIL_FORK_HPP
+#define CM_UTIL_FORK_HPP
+
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+// Fork-based what-if exploration
+//   Branches registered by add() are run in forked child processes from the current state of the
+//   simulator. The whole hierarchy, including the mmap'd pages of SimpleMemoryModel (MAP_PRIVATE),
+//   is shared with the parent copy-on-write, so a branch only pays for the state it modifies.
+//   Each branch returns a (binary safe) result string which is sent back to the parent by a pipe.
+//   Only the calling thread survives a fork: stop background writers (EpochMonitor, EventTraceWriter)
+//   before run() and restart them in the branches if needed.
+class ForkExplorer
+{
+protected:
+  struct Branch {
+    std::function<std::string()> func;
+    std::string result;
+    int status;     // exit status of the child, -1 if it failed to run
+    pid_t pid;
+    int fd;         // read end of the result pipe
+  };
+
+  std::vector<Branch> branches;
+  const unsigned int parallel;  // maximal number of concurrent children
+
+  static bool write_all(int fd, const char *p, size_t n) {
+    while(n) {
+      ssize_t w = write(fd, p, n);
+      if(w < 0) { if(errno == EINTR) continue; return false; }
+      p += w; n -= w;
+    }
+    return true;
+  }
+
+  bool spawn(Branch &b) {
+    int fds[2];
+    if(pipe(fds) != 0) return false;
+    fflush(nullptr); std::cout.flush(); std::cerr.flush(); // avoid duplicating buffered outputs
+    pid_t pid = fork();
+    if(pid < 0) { close(fds[0]); close(fds[1]); return false; }
+    if(pid == 0) { // child: run the branch and leave without running the exit handlers of the parent
+      close(fds[0]);
+      std::string r = b.func();
+      bool ok = write_all(fds[1], r.data(), r.size());
+      close(fds[1]);
+      fflush(nullptr); std::cout.flush(); std::cerr.flush();
+      _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    b.pid = pid; b.fd = fds[0];
+    return true;
+  }
+
+  void reap(Branch &b) {
+    int st;
+    close(b.fd); b.fd = -1;
+    while(waitpid(b.pid, &st, 0) < 0 && errno == EINTR);
+    b.status = WIFEXITED(st) ? WEXITSTATUS(st) : -1;
+  }
+
+  // stop collecting: kill and reap the running branches, report them and the unstarted ones as lost
+  void abandon(std::vector<size_t> &active, size_t next) {
+    for(auto i:active) kill(branches[i].pid, SIGKILL);
+    for(auto i:active) {
+      auto &b = branches[i];
+      reap(b);
+      b.result.clear(); b.status = -1;
+      std::cerr << "[ForkExplorer] Branch " << i << " is lost." << std::endl;
+    }
+    active.clear();
+    for(size_t i=next; i<branches.size(); i++) {
+      branches[i].result.clear(); branches[i].status = -1;
+      std::cerr << "[ForkExplorer] Branch " << i << " is not run." << std::endl;
+    }
+  }
+
+public:
+  ForkExplorer(unsigned int parallel = 0)
+    : parallel(parallel ? parallel : std::max(1u, std::thread::hardware_concurrency())) {}
+  virtual ~ForkExplorer() {}
+
+  // register a branch, return its index
+  uint32_t add(std::function<std::string()> func) {
+    branches.push_back(Branch{func, std::string(), -1, -1, -1});
+    return branches.size() - 1;
+  }
+
+  // run all branches (at most `parallel' at a time) and collect their results,
+  // return the number of branches which exited normally
+  uint32_t run() {
+    std::vector<size_t> active;  // running branches
+    size_t next = 0;
+    uint32_t ok = 0;
+    char buf[65536];
+    while(next < branches.size() || !active.empty()) {
+      while(next < branches.size() && active.size() < parallel) {
+        auto &b = branches[next];
+        b.result.clear(); b.status = -1;
+        if(spawn(b)) active.push_back(next);
+        else std::cerr << "[ForkExplorer] Fail to fork branch " << next << "." << std::endl;
+        next++;
+      }
+      if(active.empty()) continue;
+
+      // drain the pipes concurrently so that no child blocks on a full pipe
+      std::vector<pollfd> fds;
+      for(auto i:active) fds.push_back(pollfd{branches[i].fd, POLLIN, 0});
+      if(poll(fds.data(), fds.size(), -1) < 0) {
+        if(errno == EINTR) continue;
+        perror("[ForkExplorer] Fail to poll the result pipes");
+        abandon(active, next);
+        break;
+      }
+      for(size_t k=0; k<fds.size(); k++) {
+        if(!fds[k].revents) continue;
+        auto &b = branches[active[k]];
+        ssize_t n = read(b.fd, buf, sizeof(buf));
+        if(n > 0) b.result.append(buf, n);
+        else if(n == 0 || errno != EINTR) { // end of the result
+          reap(b);
+          if(b.status == 0) ok++;
+          active[k] = branches.size(); // mark as finished
+        }
+      }
+      std::vector<size_t> running;
+      for(auto i:active) if(i < branches.size()) running.push_back(i);
+      active.swap(running);
+    }
+    return ok;
+  }
+
+  size_t size() const { return branches.size(); }
+  const std::string &get_result(uint32_t i) const { return branches[i].result; }
+  int get_status(uint32_t i) const { return branches[i].status; }
+  void clear() { branches.clear(); }
+};
+
+#endif
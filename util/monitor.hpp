@@ -3,20 +3,55 @@
 
 #include <cstdint>
 #include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ostream>
+
+// coherence message types reported to monitors
+struct CohMsgType
+{
+  constexpr static uint32_t acquire    = 0; // fetch a missing block from the outer cache
+  constexpr static uint32_t promote    = 1; // permission upgrade of a present block (acquire for write)
+  constexpr static uint32_t writeback  = 2; // release a dirty block to the outer cache
+  constexpr static uint32_t probe      = 3; // reverse probe sent to an inner cache
+  constexpr static uint32_t probe_data = 4; // probe response carrying dirty data
+  constexpr static uint32_t fetch      = 5; // fetch missing sectors of a present block (sectored data)
+  constexpr static uint32_t count      = 6; // number of message types
+};
 
 // monitor base class
 class MonitorBase
 {
+protected:
+  const std::string name; // an optional name to describe this monitor
+
 public:
-  MonitorBase() {}
+  MonitorBase(const std::string &name = "") : name(name) {}
   virtual ~MonitorBase() {}
 
+  const std::string &get_name() const { return name; }
+
   // standard functions to supprt a type of monitoring
   virtual bool attach(uint64_t cache_id) = 0; // decide whether to attach the mointor to this cache
   virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) = 0;
   virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) = 0;
   virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) = 0;
 
+  // optional: a coherence message sent by the monitored cache
+  //   type: CohMsgType, src/dst: id of the sending/receiving cache (0 for memory)
+  virtual void message(uint64_t addr, uint32_t type, uint32_t src, uint32_t dst) {}
+
+  // optional: a probe from the outer cache hit a block of the monitored cache
+  //   (an evicting probe is also reported as invalid())
+  virtual void probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback) {}
+
+  // optional: the delay charged by the timer of the monitored cache for the event just reported
+  virtual void delay(uint64_t cycles) {}
+
+  // optional: the number of blocks owned by partition part changed by delta (way-partitioned caches only)
+  virtual void occupancy(uint32_t part, int64_t delta) {}
+
   // control
   virtual void start() = 0;    // start the monitor, assuming the monitor is just initialized
   virtual void stop() = 0;     // stop the monitor, assuming it will soon be destroyed
@@ -30,10 +65,11 @@ class PFCMonitor : public MonitorBase
 {
 protected:
   uint64_t cnt_access, cnt_miss, cnt_write, cnt_write_miss, cnt_invalid;
+  uint64_t cnt_delay; // delay charged by the timers of the monitored caches
   bool active;
 
 public:
-  PFCMonitor() : cnt_access(0), cnt_miss(0), cnt_write(0), cnt_write_miss(0), cnt_invalid(0), active(false) {}
+  PFCMonitor(const std::string &name = "") : MonitorBase(name), cnt_access(0), cnt_miss(0), cnt_write(0), cnt_write_miss(0), cnt_invalid(0), cnt_delay(0), active(false) {}
   virtual ~PFCMonitor() {}
 
   virtual bool attach(uint64_t cache_id) { return true; }
@@ -59,6 +95,11 @@ public:
     cnt_invalid++;
   }
 
+  virtual void delay(uint64_t cycles) {
+    if(!active) return;
+    cnt_delay += cycles;
+  }
+
   virtual void start() { active = true;  }
   virtual void stop()  { active = false; }
   virtual void pause() { active = false; }
@@ -69,6 +110,7 @@ public:
     cnt_write = 0;
     cnt_write_miss = 0;
     cnt_invalid = 0;
+    cnt_delay = 0;
     active = false;
   }
 
@@ -80,6 +122,93 @@ public:
   uint64_t get_miss_read() { return cnt_miss - cnt_write_miss; }
   uint64_t get_miss_write() { return cnt_write_miss; }
   uint64_t get_invalid() { return cnt_invalid; }
+  uint64_t get_delay() { return cnt_delay; }
+};
+
+// coherence traffic counter, counts messages by type, source and destination
+class CoherenceMonitor : public MonitorBase
+{
+protected:
+  std::unordered_map<uint64_t, uint64_t> cnt[CohMsgType::count]; // (src << 32 | dst) -> count for each type
+  uint64_t cnt_total[CohMsgType::count];
+  bool active;
+
+public:
+  CoherenceMonitor(const std::string &name = "") : MonitorBase(name), cnt_total{0}, active(false) {}
+  virtual ~CoherenceMonitor() {}
+
+  virtual bool attach(uint64_t cache_id) { return true; }
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {}
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {}
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) {}
+
+  virtual void message(uint64_t addr, uint32_t type, uint32_t src, uint32_t dst) {
+    if(!active) return;
+    cnt[type][(uint64_t)src << 32 | dst]++;
+    cnt_total[type]++;
+  }
+
+  virtual void start() { active = true;  }
+  virtual void stop()  { active = false; }
+  virtual void pause() { active = false; }
+  virtual void resume() { active = true; }
+  virtual void reset() {
+    for(uint32_t t=0; t<CohMsgType::count; t++) { cnt[t].clear(); cnt_total[t] = 0; }
+    active = false;
+  }
+
+  uint64_t get(uint32_t type) const { return cnt_total[type]; }
+  uint64_t get(uint32_t type, uint32_t src, uint32_t dst) const {
+    auto it = cnt[type].find((uint64_t)src << 32 | dst);
+    return it == cnt[type].end() ? 0 : it->second;
+  }
+
+  // CSV: type, source, destination, count
+  void write_csv(std::ostream &os) const {
+    const char *names[CohMsgType::count] = {"acquire", "promote", "writeback", "probe", "probe_data", "fetch"};
+    os << "type,src,dst,count" << std::endl;
+    for(uint32_t t=0; t<CohMsgType::count; t++)
+      for(auto &c:cnt[t])
+        os << names[t] << "," << (c.first >> 32) << "," << (c.first & 0xffffffffull) << "," << c.second << std::endl;
+  }
+};
+
+// partition occupancy counter, sums the blocks owned by each partition in the monitored (way-partitioned) caches
+class PartitionMonitor : public MonitorBase
+{
+protected:
+  std::vector<int64_t> cnt_occupancy; // current number of blocks of each partition
+  std::vector<int64_t> cnt_peak;      // peak number of blocks of each partition
+  bool active;
+
+public:
+  PartitionMonitor(const std::string &name = "") : MonitorBase(name), active(false) {}
+  virtual ~PartitionMonitor() {}
+
+  virtual bool attach(uint64_t cache_id) { return true; }
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {}
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {}
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) {}
+
+  // occupancy is a state rather than an event count, so it is tracked even when paused
+  virtual void occupancy(uint32_t part, int64_t delta) {
+    if(part >= cnt_occupancy.size()) { cnt_occupancy.resize(part + 1, 0); cnt_peak.resize(part + 1, 0); }
+    cnt_occupancy[part] += delta;
+    if(active && cnt_occupancy[part] > cnt_peak[part]) cnt_peak[part] = cnt_occupancy[part];
+  }
+
+  virtual void start() { active = true;  }
+  virtual void stop()  { active = false; }
+  virtual void pause() { active = false; }
+  virtual void resume() { active = true; }
+  virtual void reset() {
+    for(uint32_t p=0; p<cnt_peak.size(); p++) cnt_peak[p] = cnt_occupancy[p];
+    active = false;
+  }
+
+  uint32_t get_partitions() const { return cnt_occupancy.size(); }
+  int64_t get_occupancy(uint32_t part) const { return part < cnt_occupancy.size() ? cnt_occupancy[part] : 0; }
+  int64_t get_peak(uint32_t part) const { return part < cnt_peak.size() ? cnt_peak[part] : 0; }
 };
 
 #endif
@@ -0,0 +1,121 @@
+#ifndef CM_UTIL_PROFILE_HPP
+#define CM_UTIL_PROFILE_HPP
+
+// Simulator self-profiling
+//   When compiled with CM_PROFILE (make PROFILE=1), the time spent in the hot paths of every cache
+//   (and memory) is accumulated per category and a breakdown per cache level is printed to stderr
+//   at exit. Caches named <level>_<n> (as created by the DSL) are merged into one level.
+//   Times are measured by rdtsc (cycles) on x86-64 and by std::chrono (ns) elsewhere.
+//   Categories are inclusive: hit and replace contain the index hashing of the same call,
+//   probe contains the probes of the inner caches.
+//   Without CM_PROFILE all instrumentation compiles to nothing.
+
+#ifdef CM_PROFILE
+
+#include <cstdio>
+#include <cstdint>
+#include <cctype>
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline uint64_t cm_profile_clock() { return __rdtsc(); }
+#define CM_PROFILE_UNIT "cycles"
+#else
+#include <chrono>
+inline uint64_t cm_profile_clock() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#define CM_PROFILE_UNIT "ns"
+#endif
+
+struct CMProfileEntry
+{
+  constexpr static int HIT      = 0; // CacheBase::hit()
+  constexpr static int REPLACE  = 1; // CacheBase::replace()
+  constexpr static int INDEX    = 2; // index hashing
+  constexpr static int REPLACER = 3; // replacer state update
+  constexpr static int PROBE    = 4; // coherence probes sent to inner caches
+  constexpr static int MEMORY   = 5; // memory model accesses
+  constexpr static int MONITOR  = 6; // monitor dispatch
+  constexpr static int NCAT     = 7;
+
+  uint64_t time[NCAT];
+  uint64_t calls[NCAT];
+};
+
+// registry of profile entries, one per cache, reported at exit
+class CMProfiler
+{
+  std::mutex lock;
+  std::vector<std::pair<std::string, std::unique_ptr<CMProfileEntry> > > entries;
+  const uint64_t start;
+
+  static std::string level(const std::string &name) { // strip the trailing _<n> of a cache array
+    auto pos = name.find_last_of('_');
+    if(pos == std::string::npos || pos+1 == name.size()) return name;
+    for(auto i=pos+1; i<name.size(); i++) if(!isdigit(name[i])) return name;
+    return name.substr(0, pos);
+  }
+
+public:
+  CMProfiler() : start(cm_profile_clock()) {}
+
+  ~CMProfiler() {
+    const char *cat[CMProfileEntry::NCAT] = {"hit", "replace", "index", "replacer", "probe", "memory", "monitor"};
+    uint64_t total = cm_profile_clock() - start;
+    std::map<std::string, CMProfileEntry> levels;
+    for(auto &e:entries) {
+      auto &l = levels.emplace(level(e.first), CMProfileEntry{{0}, {0}}).first->second;
+      for(int c=0; c<CMProfileEntry::NCAT; c++) { l.time[c] += e.second->time[c]; l.calls[c] += e.second->calls[c]; }
+    }
+    fprintf(stderr, "[Profile] run time %lu %s\n", total, CM_PROFILE_UNIT);
+    fprintf(stderr, "%-16s %-10s %14s %18s %10s %8s\n", "level", "category", "calls", "time(" CM_PROFILE_UNIT ")", "avg", "share");
+    for(auto &l:levels)
+      for(int c=0; c<CMProfileEntry::NCAT; c++) {
+        if(!l.second.calls[c]) continue;
+        fprintf(stderr, "%-16s %-10s %14lu %18lu %10.1f %7.2f%%\n", l.first.empty() ? "(unnamed)" : l.first.c_str(), cat[c],
+                l.second.calls[c], l.second.time[c], (double)l.second.time[c] / l.second.calls[c],
+                total ? 100.0 * l.second.time[c] / total : 0.0);
+      }
+  }
+
+  // each cache owns its entry so that caches simulated by different threads never share counters
+  static CMProfileEntry *entry(const std::string &name) {
+    static CMProfiler profiler;
+    std::lock_guard<std::mutex> guard(profiler.lock);
+    profiler.entries.emplace_back(name, std::unique_ptr<CMProfileEntry>(new CMProfileEntry{{0}, {0}}));
+    return profiler.entries.back().second.get();
+  }
+};
+
+class CMProfileScope
+{
+  CMProfileEntry *entry;
+  const int cat;
+  const uint64_t begin;
+
+public:
+  CMProfileScope(CMProfileEntry *entry, int cat) : entry(entry), cat(cat), begin(cm_profile_clock()) {}
+  ~CMProfileScope() {
+    entry->time[cat] += cm_profile_clock() - begin;
+    entry->calls[cat]++;
+  }
+};
+
+#define CM_PROFILE_CAT_(a, b) a##b
+#define CM_PROFILE_CAT(a, b) CM_PROFILE_CAT_(a, b)
+// time the rest of the enclosing scope into category cat (CMProfileEntry::cat) of entry e
+#define CM_PROFILE_SCOPE(e, cat) CMProfileScope CM_PROFILE_CAT(cm_profile_scope_, __LINE__)(e, CMProfileEntry::cat)
+
+#else
+
+#define CM_PROFILE_SCOPE(e, cat)
+
+#endif
+
+#endif
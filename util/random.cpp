@@ -1,15 +1,28 @@
 #include "util/random.hpp"
 #include <random>
+#include <sstream>
 
 // local variables (file local linkage)
+//   thread local so that caches simulated in different threads have independent and reproducible streams
 namespace {
-  std::default_random_engine gen;
-  std::uniform_int_distribution<uint32_t> uniform32(0, 1ul<<31);
-  std::uniform_int_distribution<uint64_t> uniform64(0, 1ull<<63);
+  thread_local std::default_random_engine gen;
+  thread_local std::uniform_int_distribution<uint32_t> uniform32(0, 1ul<<31);
+  thread_local std::uniform_int_distribution<uint64_t> uniform64(0, 1ull<<63);
 }
 
 void cm_set_random_seed(uint64_t seed) { gen.seed(seed); }
 uint64_t cm_get_random_uint64() { return uniform64(gen); }
 uint32_t cm_get_random_uint32() { return uniform32(gen); }
 
+std::string cm_get_random_state() {
+  std::ostringstream os;
+  os << gen << " " << uniform32 << " " << uniform64;
+  return os.str();
+}
+
+void cm_set_random_state(const std::string &state) {
+  std::istringstream is(state);
+  is >> gen >> uniform32 >> uniform64;
+}
+
 std::unordered_set<uint32_t> UniqueID::ids;
@@ -2,11 +2,14 @@
 #define CM_UTIL_RANDOM_HPP_
 
 #include <cstdint>
+#include <string>
 #include <unordered_set>
 
-extern void cm_set_random_seed(uint64_t seed);
+extern void cm_set_random_seed(uint64_t seed); // seed the random generator of the calling thread
 extern uint64_t cm_get_random_uint64();
 extern uint32_t cm_get_random_uint32();
+extern std::string cm_get_random_state();                // serialized state of the random generator of the calling thread
+extern void cm_set_random_state(const std::string &state);
 
 #include "cryptopp/cryptlib.h"
 #include "cryptopp/tiger.h"
@@ -36,6 +39,8 @@ public:
   void seed(uint64_t s) {
     *(uint64_t *)(msg+8) = s;
   }
+
+  uint64_t get_seed() const { return *(const uint64_t *)(msg+8); }
 };
 
 // record and generate a unique ID
@@ -0,0 +1,168 @@
+#ifndef CM_UTIL_REUSE_HPP
+#define CM_UTIL_REUSE_HPP
+
+#include <cstdint>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <ostream>
+#include "util/monitor.hpp"
+
+// Reuse-distance and set-conflict profiler
+//   A monitor profiling the access stream of a single cache (attach one instance per cache):
+//   - reuse distance (number of distinct blocks accessed between two accesses to the same block)
+//     histograms in log2 buckets, for the whole cache and for each set
+//     (a per-set histogram bins the cache-wide reuse distances of the accesses to that set,
+//      not distances counted among the blocks of the set alone)
+//   - per-set access, miss and eviction (invalidation) heatmaps
+//   Reuse distances are counted by a Fenwick tree over access time, O(log n) per access.
+class ReuseProfileMonitor : public MonitorBase
+{
+public:
+  static constexpr int NB = 34; // number of histogram buckets: [0] distance 0, [i] distance in [2^(i-1), 2^i), [NB-1] cold
+
+protected:
+  struct SetStat {
+    uint64_t access, miss, evict;
+    uint64_t hist[NB];
+  };
+
+  const int block_offset;
+  uint64_t cache_id;
+  bool attached;
+  bool active;
+
+  // reuse distance engine
+  std::unordered_map<uint64_t, uint64_t> last; // block -> time slot of its latest access
+  std::vector<int64_t> tree;                   // Fenwick tree, one for the latest slot of each live block
+  uint64_t now;                                // next time slot
+
+  uint64_t hist[NB];                           // cache-wide histogram
+  std::vector<std::vector<SetStat> > sets;     // per-set statistics, indexed by [ai][s]
+
+  void tree_add(uint64_t i, int64_t v) { for(i++; i <= tree.size(); i += i & (-i)) tree[i-1] += v; }
+  int64_t tree_sum(uint64_t i) const { int64_t r = 0; for(; i > 0; i -= i & (-i)) r += tree[i-1]; return r; } // sum of slots [0, i)
+
+  // renumber the live blocks into [0, n) when the time slots run out
+  void compact() {
+    std::vector<std::pair<uint64_t, uint64_t> > live; // (slot, block)
+    live.reserve(last.size());
+    for(auto &l:last) live.push_back(std::make_pair(l.second, l.first));
+    std::sort(live.begin(), live.end());
+    size_t cap = std::max<size_t>(tree.size(), 2*live.size() + 1024);
+    tree.assign(cap, 0);
+    for(now = 0; now < live.size(); now++) {
+      last[live[now].second] = now;
+      tree_add(now, 1);
+    }
+  }
+
+  static int bucket(uint64_t d) { return d == 0 ? 0 : std::min(NB-2, 64 - __builtin_clzll(d)); }
+
+  SetStat &set_stat(uint32_t ai, uint32_t s) {
+    if(sets.size() <= ai) sets.resize(ai+1);
+    if(sets[ai].size() <= s) sets[ai].resize(s+1, SetStat{0, 0, 0, {0}});
+    return sets[ai][s];
+  }
+
+  void access(uint64_t addr, uint32_t ai, uint32_t s, bool hit) {
+    auto &ss = set_stat(ai, s);
+    ss.access++;
+    if(!hit) ss.miss++;
+
+    if(now == tree.size()) compact();
+    uint64_t blk = addr >> block_offset;
+    int b = NB-1;
+    auto it = last.find(blk);
+    if(it != last.end()) {
+      b = bucket(tree_sum(now) - tree_sum(it->second + 1));
+      tree_add(it->second, -1);
+    }
+    hist[b]++;
+    ss.hist[b]++;
+    tree_add(now, 1);
+    last[blk] = now++;
+  }
+
+public:
+  ReuseProfileMonitor(int block_offset = 6, size_t capacity = 1ul << 20)
+    : block_offset(block_offset), cache_id(0), attached(false), active(false), tree(capacity, 0), now(0), hist{0} {}
+  virtual ~ReuseProfileMonitor() {}
+
+  // a profile describes a single cache
+  virtual bool attach(uint64_t id) {
+    if(attached) return id == cache_id;
+    cache_id = id; attached = true;
+    return true;
+  }
+
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit)  { if(active) access(addr, ai, s, hit); }
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) { if(active) access(addr, ai, s, hit); }
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) { if(active) set_stat(ai, s).evict++; }
+
+  virtual void start() { active = true;  }
+  virtual void stop()  { active = false; }
+  virtual void pause() { active = false; }
+  virtual void resume() { active = true; }
+  virtual void reset() {
+    last.clear();
+    std::fill(tree.begin(), tree.end(), 0);
+    now = 0;
+    std::fill(hist, hist+NB, 0);
+    sets.clear();
+    active = false;
+  }
+
+  const uint64_t *get_histogram() const { return hist; }
+  // per-set statistics exist only up to the highest partition and set touched so far
+  bool has_set(uint32_t ai, uint32_t s) const { return ai < sets.size() && s < sets[ai].size(); }
+  const uint64_t *get_histogram(uint32_t ai, uint32_t s) const { assert(has_set(ai, s)); return sets[ai][s].hist; }
+  uint64_t get_miss(uint32_t ai, uint32_t s) const { assert(has_set(ai, s)); return sets[ai][s].miss; }
+  uint64_t get_evict(uint32_t ai, uint32_t s) const { assert(has_set(ai, s)); return sets[ai][s].evict; }
+
+  // CSV: one row per set (partition, set, access, miss, evict, histogram buckets),
+  //      the cache-wide histogram is written as partition `all'
+  void write_csv(std::ostream &os) const {
+    os << "partition,set,access,miss,evict";
+    for(int i=0; i<NB-1; i++) os << ",rd" << i;
+    os << ",cold" << std::endl;
+    uint64_t access = 0, miss = 0, evict = 0;
+    for(uint32_t ai=0; ai<sets.size(); ai++)
+      for(uint32_t s=0; s<sets[ai].size(); s++) {
+        auto &ss = sets[ai][s];
+        access += ss.access; miss += ss.miss; evict += ss.evict;
+        os << ai << "," << s << "," << ss.access << "," << ss.miss << "," << ss.evict;
+        for(int i=0; i<NB; i++) os << "," << ss.hist[i];
+        os << std::endl;
+      }
+    os << "all,," << access << "," << miss << "," << evict;
+    for(int i=0; i<NB; i++) os << "," << hist[i];
+    os << std::endl;
+  }
+
+  // JSON: {"cache": id, "histogram": [...], "sets": [[{"access":..,"miss":..,"evict":..,"histogram":[...]}, ...], ...]}
+  void write_json(std::ostream &os) const {
+    auto write_hist = [&os](const uint64_t *h) {
+      os << "[";
+      for(int i=0; i<NB; i++) os << (i ? "," : "") << h[i];
+      os << "]";
+    };
+    os << "{\"cache\":" << cache_id << ",\"histogram\":";
+    write_hist(hist);
+    os << ",\"sets\":[";
+    for(uint32_t ai=0; ai<sets.size(); ai++) {
+      os << (ai ? "," : "") << "[";
+      for(uint32_t s=0; s<sets[ai].size(); s++) {
+        auto &ss = sets[ai][s];
+        os << (s ? "," : "") << "{\"access\":" << ss.access << ",\"miss\":" << ss.miss << ",\"evict\":" << ss.evict << ",\"histogram\":";
+        write_hist(ss.hist);
+        os << "}";
+      }
+      os << "]";
+    }
+    os << "]}" << std::endl;
+  }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef CM_UTIL_SAMPLER_HPP
+#define CM_UTIL_SAMPLER_HPP
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "util/monitor.hpp"
+
+// Set-sampling monitor
+//   Forwards events only for a subset of the sets of a cache to the wrapped monitors,
+//   so that expensive fine-grained monitors only pay for the sampled sets.
+//   Sets are selected by a fixed stride (every ratio-th set) or by a hash of (partition, set).
+//   The sampler keeps per-set access and miss counters of the sampled sets to estimate
+//   the totals of the whole cache with their standard errors.
+//   Events of partitions beyond npart (e.g. the victim array of CacheVictim) are dropped.
+//   Messages and occupancy changes are not tied to a set and are forwarded unsampled,
+//   while a delay is forwarded only when the event it is charged for was sampled.
+class SampledMonitor : public MonitorBase
+{
+protected:
+  const uint32_t nset;                  // number of sets per partition
+  const uint32_t npart;                 // number of partitions
+  std::vector<uint32_t> sample;         // sample index + 1 of each (partition, set), 0 if not sampled
+  std::vector<uint64_t> cnt_access, cnt_miss, cnt_invalid; // per sampled set
+  std::vector<MonitorBase *> monitors;  // wrapped monitors
+  bool active;
+  bool last;                            // whether the last set event was sampled
+
+  static uint64_t mix(uint64_t x) { // splitmix64 finalizer
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  // sample index + 1 of (partition, set), 0 if not sampled or not active
+  uint32_t sampled(uint32_t ai, uint32_t s) {
+    last = active && ai < npart && s < nset && sample[ai*nset + s];
+    return last ? sample[ai*nset + s] : 0;
+  }
+
+  // estimate the total of a per-set counter over all sets
+  double estimate(const std::vector<uint64_t> &cnt) const {
+    double sum = 0;
+    for(auto c:cnt) sum += c;
+    return sum * scale();
+  }
+
+  // standard error of the estimated total (sampling without replacement)
+  double error(const std::vector<uint64_t> &cnt) const {
+    double n = cnt.size(), N = (double)nset * npart;
+    if(n < 2) return 0.0;
+    double mean = 0, var = 0;
+    for(auto c:cnt) mean += c;
+    mean /= n;
+    for(auto c:cnt) var += (c - mean) * (c - mean);
+    var /= n - 1;
+    return N * std::sqrt((1.0 - n/N) * var / n);
+  }
+
+public:
+  // ratio: sample one out of every ratio sets
+  // hashed: select sets by hash (with seed) rather than by a fixed stride
+  SampledMonitor(uint32_t nset, uint32_t npart, uint32_t ratio, bool hashed = false, uint64_t seed = 0)
+    : nset(nset), npart(npart), sample(nset * npart, 0), active(false), last(false)
+  {
+    uint32_t n = 0;
+    for(uint32_t ai=0; ai<npart; ai++)
+      for(uint32_t s=0; s<nset; s++) {
+        bool sel = hashed ? mix(((uint64_t)ai << 32 | s) ^ seed) % ratio == 0 : s % ratio == 0;
+        if(sel) sample[ai*nset + s] = ++n;
+      }
+    cnt_access.resize(n, 0);
+    cnt_miss.resize(n, 0);
+    cnt_invalid.resize(n, 0);
+  }
+  virtual ~SampledMonitor() {}
+
+  // wrap a monitor, must be done before attaching the sampler to a cache
+  void add(MonitorBase *m) { monitors.push_back(m); }
+
+  virtual bool attach(uint64_t cache_id) {
+    bool rv = true;
+    for(auto m:monitors) rv &= m->attach(cache_id);
+    return rv;
+  }
+
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {
+    uint32_t i = sampled(ai, s);
+    if(!i) return;
+    cnt_access[i-1]++;
+    if(!hit) cnt_miss[i-1]++;
+    for(auto m:monitors) m->read(addr, ai, s, w, hit);
+  }
+
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) {
+    uint32_t i = sampled(ai, s);
+    if(!i) return;
+    cnt_access[i-1]++;
+    if(!hit) cnt_miss[i-1]++;
+    for(auto m:monitors) m->write(addr, ai, s, w, hit);
+  }
+
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) {
+    uint32_t i = sampled(ai, s);
+    if(!i) return;
+    cnt_invalid[i-1]++;
+    for(auto m:monitors) m->invalid(addr, ai, s, w);
+  }
+
+  virtual void probe(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool evict, bool writeback) {
+    if(!sampled(ai, s)) return;
+    for(auto m:monitors) m->probe(addr, ai, s, w, evict, writeback);
+  }
+
+  virtual void delay(uint64_t cycles) {
+    if(!last) return;
+    for(auto m:monitors) m->delay(cycles);
+  }
+
+  virtual void message(uint64_t addr, uint32_t type, uint32_t src, uint32_t dst) {
+    if(!active) return;
+    for(auto m:monitors) m->message(addr, type, src, dst);
+  }
+
+  virtual void occupancy(uint32_t part, int64_t delta) {
+    for(auto m:monitors) m->occupancy(part, delta);
+  }
+
+  virtual void start()  { active = true;  for(auto m:monitors) m->start();  }
+  virtual void stop()   { active = false; for(auto m:monitors) m->stop();   }
+  virtual void pause()  { active = false; for(auto m:monitors) m->pause();  }
+  virtual void resume() { active = true;  for(auto m:monitors) m->resume(); }
+  virtual void reset() {
+    std::fill(cnt_access.begin(), cnt_access.end(), 0);
+    std::fill(cnt_miss.begin(), cnt_miss.end(), 0);
+    std::fill(cnt_invalid.begin(), cnt_invalid.end(), 0);
+    active = false;
+    last = false;
+    for(auto m:monitors) m->reset();
+  }
+
+  // factor to scale a counter collected on the sampled sets to the whole cache
+  double scale() const { return cnt_access.empty() ? 0.0 : (double)nset * npart / cnt_access.size(); }
+  uint32_t get_sampled_sets() const { return cnt_access.size(); }
+
+  // estimated totals of the whole cache and their standard errors
+  double get_access() const { return estimate(cnt_access); }
+  double get_miss() const { return estimate(cnt_miss); }
+  double get_invalid() const { return estimate(cnt_invalid); }
+  double get_access_error() const { return error(cnt_access); }
+  double get_miss_error() const { return error(cnt_miss); }
+  double get_invalid_error() const { return error(cnt_invalid); }
+};
+
+#endif
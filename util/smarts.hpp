@@ -0,0 +1,149 @@
+#ifndef CM_UTIL_SMARTS_HPP
+#define CM_UTIL_SMARTS_HPP
+
+#include <cassert>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <ostream>
+
+#include "util/trace.hpp"
+#include "util/monitor.hpp"
+#include "cache/coherence.hpp"
+
+// Sampled simulation (SMARTS-style)
+//   The trace is divided into sampling units of (functional + warm + measure) accesses:
+//   - functional warming: the hierarchy runs in fast-forward mode (no delay estimation or monitoring);
+//                         this keeps warm-up out of the statistics but costs about as much per access
+//                         as detailed simulation (see CacheBase::set_fast_forward())
+//   - detailed warming:   full simulation without measurement, to warm the delay relevant states
+//   - measurement:        full simulation, the miss rate and the average delay of each level (by the
+//                         PFCMonitor of the level) and the average delay per access are recorded for this unit
+//   The delay of a level is the delay charged by the timers of its caches per access of the level,
+//   which requires the caches to enable monitoring and delay estimation.
+//   The metrics are estimated by the mean over all units with a confidence interval of
+//   z * s / sqrt(n) (z = 1.96 for 95% confidence by default).
+class SmartsDriver
+{
+public:
+  struct Estimate {
+    double mean;
+    double error;   // half width of the confidence interval
+    uint64_t n;     // number of measured units
+  };
+
+protected:
+  struct Level {
+    std::string name;
+    PFCMonitor *pfc;
+    uint64_t access, miss, delay;     // counters at the beginning of the measurement
+    std::vector<double> samples;      // miss rate of each unit
+    std::vector<double> delay_samples; // average delay per access of the level of each unit
+  };
+
+  const uint64_t functional, warm, measure;
+  const double z;
+  std::function<void(bool)> set_fast_forward;
+  std::vector<Level> levels;
+  std::vector<double> delays;    // average delay per access of each unit
+
+  static Estimate estimate(const std::vector<double> &v, double z) {
+    Estimate e{0.0, 0.0, v.size()};
+    if(v.empty()) return e;
+    for(auto x:v) e.mean += x;
+    e.mean /= v.size();
+    if(v.size() > 1) {
+      double var = 0.0;
+      for(auto x:v) var += (x - e.mean) * (x - e.mean);
+      var /= v.size() - 1;
+      e.error = z * std::sqrt(var / v.size());
+    }
+    return e;
+  }
+
+  // snapshot the counters at the beginning of a measurement
+  void begin_measure(uint64_t *delay) {
+    *delay = 0;
+    for(auto &l:levels) { l.access = l.pfc->get_access(); l.miss = l.pfc->get_miss(); l.delay = l.pfc->get_delay(); }
+  }
+
+  void end_measure(uint64_t delay) {
+    delays.push_back((double)delay / measure);
+    for(auto &l:levels) {
+      uint64_t a = l.pfc->get_access() - l.access;
+      l.samples.push_back(a ? (double)(l.pfc->get_miss() - l.miss) / a : 0.0);
+      l.delay_samples.push_back(a ? (double)(l.pfc->get_delay() - l.delay) / a : 0.0);
+    }
+  }
+
+  static void issue(const std::vector<CoreInterfaceBase *> &cores, const TraceRecord *rec, size_t n, uint64_t *delay) {
+    for(size_t i=0; i<n; i++) {
+      assert(rec[i].core < cores.size());
+      if(rec[i].write) cores[rec[i].core]->write(rec[i].addr, nullptr, delay);
+      else             cores[rec[i].core]->read(rec[i].addr, delay);
+    }
+  }
+
+public:
+  // functional/warm/measure: number of accesses of each phase in a sampling unit
+  // set_fast_forward: switch the hierarchy between fast-forward and detailed mode (e.g. the generated set_fast_forward())
+  SmartsDriver(uint64_t functional, uint64_t warm, uint64_t measure, std::function<void(bool)> set_fast_forward, double z = 1.96)
+    : functional(functional), warm(warm), measure(measure), z(z), set_fast_forward(set_fast_forward) { assert(measure > 0); }
+  virtual ~SmartsDriver() {}
+
+  // measure the miss rate of a level by a started PFCMonitor attached to all caches of the level
+  void add_level(const std::string &name, PFCMonitor *pfc) { levels.push_back(Level{name, pfc, 0, 0, 0, {}, {}}); }
+
+  // run n records (0 for the whole trace), return the number of records issued
+  uint64_t run(TraceReaderBase &src, const std::vector<CoreInterfaceBase *> &cores, uint64_t n = 0, size_t chunk = 4096) {
+    std::vector<TraceRecord> buf(chunk);
+    const uint64_t unit = functional + warm + measure;
+    uint64_t issued = 0, pos = 0, delay = 0; // pos: position in the current unit
+    set_fast_forward(functional > 0);
+    if(functional + warm == 0) begin_measure(&delay);
+    while(n == 0 || issued < n) {
+      size_t m = src.read(buf.data(), n ? std::min<uint64_t>(chunk, n - issued) : chunk);
+      if(m == 0) break;
+      size_t i = 0;
+      while(i < m) {
+        // issue up to the next phase boundary
+        uint64_t boundary = pos < functional ? functional : pos < functional + warm ? functional + warm : unit;
+        size_t k = std::min<uint64_t>(m - i, boundary - pos);
+        issue(cores, buf.data() + i, k, pos >= functional + warm ? &delay : nullptr);
+        i += k; pos += k;
+        if(pos == unit) { // finish measurement and start the next unit
+          end_measure(delay);
+          pos = 0;
+          set_fast_forward(functional > 0);
+        }
+        if(pos == functional && functional > 0) set_fast_forward(false);
+        if(pos == functional + warm) begin_measure(&delay);
+      }
+      issued += m;
+    }
+    set_fast_forward(false);
+    return issued;
+  }
+
+  Estimate get_miss_rate(uint32_t level) const { return estimate(levels[level].samples, z); }
+  Estimate get_level_delay(uint32_t level) const { return estimate(levels[level].delay_samples, z); }
+  Estimate get_delay() const { return estimate(delays, z); }
+  uint64_t get_units() const { return delays.size(); }
+
+  // CSV: metric, mean, error (confidence half width), units
+  void write_csv(std::ostream &os) const {
+    os << "metric,mean,error,units" << std::endl;
+    for(uint32_t i=0; i<levels.size(); i++) {
+      auto e = get_miss_rate(i);
+      os << levels[i].name << ".miss_rate," << e.mean << "," << e.error << "," << e.n << std::endl;
+      e = get_level_delay(i);
+      os << levels[i].name << ".delay_per_access," << e.mean << "," << e.error << "," << e.n << std::endl;
+    }
+    auto e = get_delay();
+    os << "delay_per_access," << e.mean << "," << e.error << "," << e.n << std::endl;
+  }
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef CM_UTIL_STACK_DISTANCE_HPP
+#define CM_UTIL_STACK_DISTANCE_HPP
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <ostream>
+#include "util/monitor.hpp"
+
+/////////////////////////////////
+// Mattson stack-distance simulation for LRU set-associative caches
+//   computes the miss ratio of every cache with 2^0..2^IW sets (indexed as IndexNorm<k, IOfst>)
+//   and 1..NW ways (replaced as ReplaceLRU) in a single pass
+//   IW: maximal index width, NW: maximal number of ways, IOfst: index offset (block offset)
+//
+//   For each index width, every set keeps a bounded LRU stack of depth NW (most recent first).
+//   The position of a block in its stack is its stack distance and the block hits in all caches
+//   of that set number with more ways than its distance. Blocks deeper than NW miss in all of them.
+//   It can be used standalone by calling access() or attached to a cache as a monitor to
+//   profile the access stream seen by that cache.
+template<int IW, int NW, int IOfst>
+class StackDistanceLRU : public MonitorBase
+{
+protected:
+  std::vector<uint64_t> stacks[IW+1]; // LRU stacks of each index width, 0 for an empty entry
+  uint64_t hist[IW+1][NW];            // stack distance histograms
+  uint64_t cnt_access;
+  bool active;
+
+public:
+  StackDistanceLRU() : cnt_access(0), active(false) {
+    for(int k=0; k<=IW; k++) stacks[k].resize((1ull<<k)*NW, 0);
+    memset(hist, 0, sizeof(hist));
+  }
+  virtual ~StackDistanceLRU() {}
+
+  void access(uint64_t addr) {
+    uint64_t blk = (addr >> IOfst) + 1; // avoid 0 which marks an empty entry
+    cnt_access++;
+    for(int k=0; k<=IW; k++) {
+      uint64_t *stack = stacks[k].data() + ((addr >> IOfst) & ((1ull<<k)-1)) * NW;
+      int d = 0;
+      while(d < NW && stack[d] != blk) d++;
+      if(d < NW) hist[k][d]++;
+      else       d = NW-1; // miss in all ways, drop the LRU block
+      memmove(stack+1, stack, d*sizeof(uint64_t));
+      stack[0] = blk;
+    }
+  }
+
+  // miss ratio of a cache with 2^iw sets and nw ways
+  double miss_ratio(int iw, int nw) const {
+    if(cnt_access == 0) return 0.0;
+    uint64_t hits = 0;
+    for(int d=0; d<nw && d<NW; d++) hits += hist[iw][d];
+    return (double)(cnt_access - hits) / cnt_access;
+  }
+
+  uint64_t get_access() const { return cnt_access; }
+  uint64_t get_miss(int iw, int nw) const {
+    uint64_t hits = 0;
+    for(int d=0; d<nw && d<NW; d++) hits += hist[iw][d];
+    return cnt_access - hits;
+  }
+
+  // write the full miss ratio curve in CSV: sets, ways, blocks, misses, miss ratio
+  void write_curve(std::ostream &os) const {
+    os << "sets,ways,blocks,misses,miss_ratio" << std::endl;
+    for(int k=0; k<=IW; k++) {
+      uint64_t hits = 0;
+      for(int w=1; w<=NW; w++) {
+        hits += hist[k][w-1];
+        os << (1ull<<k) << "," << w << "," << (1ull<<k)*w << "," << cnt_access - hits << ","
+           << (cnt_access ? (double)(cnt_access - hits) / cnt_access : 0.0) << std::endl;
+      }
+    }
+  }
+
+  // monitor interface, profile the access stream of the attached cache
+  virtual bool attach(uint64_t cache_id) { return true; }
+  virtual void read(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit)  { if(active) access(addr); }
+  virtual void write(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w, bool hit) { if(active) access(addr); }
+  virtual void invalid(uint64_t addr, uint32_t ai, uint32_t s, uint32_t w) {}
+
+  virtual void start() { active = true;  }
+  virtual void stop()  { active = false; }
+  virtual void pause() { active = false; }
+  virtual void resume() { active = true; }
+  virtual void reset() {
+    for(int k=0; k<=IW; k++) std::fill(stacks[k].begin(), stacks[k].end(), 0);
+    memset(hist, 0, sizeof(hist));
+    cnt_access = 0;
+    active = false;
+  }
+};
+
+#endif
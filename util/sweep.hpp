@@ -0,0 +1,143 @@
+#ifndef CM_UTIL_SWEEP_HPP
+#define CM_UTIL_SWEEP_HPP
+
+#include <cassert>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "util/random.hpp"
+#include "util/trace.hpp"
+#include "cache/coherence.hpp"
+
+// Single-pass multi-configuration sweep
+//   Each trace chunk is decoded once and replayed on all registered configurations.
+//   A configuration is described by the core interfaces of its hierarchy (indexed by core id),
+//   for example the `inner' ports of the L1 caches of a generated hierarchy.
+//   Configurations must not share caches when replayed by multiple threads.
+class SweepDriver
+{
+protected:
+  struct Config {
+    std::vector<CoreInterfaceBase *> cores;
+    uint64_t delay;  // accumulated delay
+    uint64_t access; // number of replayed accesses
+    std::string rng; // random generator state saved between chunks, empty before the first chunk
+  };
+
+  std::vector<Config> configs;
+  std::vector<TraceRecord> buffer[2]; // double buffer, decode one while replaying the other
+  const size_t chunk;                 // number of records per chunk
+  uint64_t seed;                      // configuration c is replayed with the random stream seeded by seed + c
+
+  // worker synchronization
+  std::mutex mtx;
+  std::condition_variable cv_start, cv_done;
+  uint64_t generation;  // increased when a new chunk is published
+  unsigned int pending; // number of workers still replaying the current chunk
+  size_t cur_size;      // size of the current chunk
+  int cur_buf;          // index of the current chunk buffer
+  bool finish;
+
+  // each configuration owns its random stream, which is swapped in and out of the replaying thread
+  //   so that results do not depend on the number of threads or on how configurations are distributed
+  void replay(uint32_t c, const TraceRecord *rec, size_t n) {
+    auto &cfg = configs[c];
+    if(cfg.rng.empty()) cm_set_random_seed(seed + c);
+    else                cm_set_random_state(cfg.rng);
+    for(size_t i=0; i<n; i++) {
+      assert(rec[i].core < cfg.cores.size());
+      auto core = cfg.cores[rec[i].core];
+      if(rec[i].write) core->write(rec[i].addr, nullptr, &cfg.delay);
+      else             core->read(rec[i].addr, &cfg.delay);
+    }
+    cfg.access += n;
+    cfg.rng = cm_get_random_state();
+  }
+
+  void worker(unsigned int tid, unsigned int nthread) {
+    uint64_t seen = 0;
+    while(true) {
+      size_t n; int b;
+      {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv_start.wait(lk, [&]{ return finish || generation != seen; });
+        if(finish) return;
+        seen = generation; n = cur_size; b = cur_buf;
+      }
+      for(uint32_t c=tid; c<configs.size(); c+=nthread) replay(c, buffer[b].data(), n);
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        if(--pending == 0) cv_done.notify_one();
+      }
+    }
+  }
+
+public:
+  SweepDriver(size_t chunk = 65536, uint64_t seed = 0)
+    : chunk(chunk), seed(seed), generation(0), pending(0), cur_size(0), cur_buf(0), finish(false)
+  {
+    buffer[0].resize(chunk);
+    buffer[1].resize(chunk);
+  }
+
+  virtual ~SweepDriver() {}
+
+  // register a configuration, return its index
+  uint32_t add(const std::vector<CoreInterfaceBase *> &cores) {
+    configs.push_back(Config{cores, 0, 0, std::string()});
+    return configs.size() - 1;
+  }
+
+  // replay the whole trace on all configurations, return the number of records replayed
+  //   nthread: 0 replays all configurations in the calling thread,
+  //            otherwise configurations are distributed over nthread worker threads
+  uint64_t run(TraceReaderBase &reader, unsigned int nthread = 0) {
+    uint64_t total = 0;
+    int b = 0;
+    size_t n = reader.read(buffer[b].data(), chunk);
+
+    if(nthread == 0) {
+      while(n) {
+        for(uint32_t c=0; c<configs.size(); c++) replay(c, buffer[b].data(), n);
+        total += n;
+        n = reader.read(buffer[b].data(), chunk);
+      }
+      return total;
+    }
+
+    if(nthread > configs.size()) nthread = configs.size();
+    finish = false;
+    std::vector<std::thread> workers;
+    for(unsigned int t=0; t<nthread; t++) workers.emplace_back(&SweepDriver::worker, this, t, nthread);
+
+    while(n) {
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        cur_size = n; cur_buf = b; pending = nthread; generation++;
+      }
+      cv_start.notify_all();
+      total += n;
+      b ^= 1;
+      n = reader.read(buffer[b].data(), chunk); // decode the next chunk while the workers replay
+      std::unique_lock<std::mutex> lk(mtx);
+      cv_done.wait(lk, [&]{ return pending == 0; });
+    }
+
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      finish = true;
+    }
+    cv_start.notify_all();
+    for(auto &t:workers) t.join();
+    return total;
+  }
+
+  size_t size() const { return configs.size(); }
+  uint64_t get_delay(uint32_t c) const { return configs[c].delay; }
+  uint64_t get_access(uint32_t c) const { return configs[c].access; }
+};
+
+#endif
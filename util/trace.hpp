@@ -0,0 +1,75 @@
+#ifndef CM_UTIL_TRACE_HPP
+#define CM_UTIL_TRACE_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// a decoded memory access
+struct TraceRecord
+{
+  uint64_t addr;  // accessed address
+  uint32_t core;  // index of the issuing core
+  uint32_t write; // 0: read, 1: write
+};
+
+// base class for a trace source, which decodes records in chunks
+class TraceReaderBase
+{
+public:
+  TraceReaderBase() {}
+  virtual ~TraceReaderBase() {}
+
+  // decode at most n records into buf, return the number of records decoded (0 when exhausted)
+  virtual size_t read(TraceRecord *buf, size_t n) = 0;
+};
+
+// text trace, one access per line: <core> <r|w> <hex address>
+class TraceReaderText : public TraceReaderBase
+{
+protected:
+  FILE *file;
+  char line[256];
+
+public:
+  TraceReaderText(const std::string &fn) : file(fopen(fn.c_str(), "r")) {}
+  virtual ~TraceReaderText() { if(file) fclose(file); }
+
+  bool good() const { return file != nullptr; }
+
+  virtual size_t read(TraceRecord *buf, size_t n) {
+    size_t i = 0;
+    if(!file) return 0;
+    while(i < n && fgets(line, sizeof(line), file)) {
+      char *p = line;
+      auto core = strtoul(p, &p, 10);
+      while(*p == ' ' || *p == '\t') p++;
+      if(*p != 'r' && *p != 'w' && *p != 'R' && *p != 'W') continue; // skip blank or malformed lines
+      buf[i].write = (*p == 'w' || *p == 'W');
+      buf[i].addr = strtoull(p+1, nullptr, 16);
+      buf[i].core = core;
+      i++;
+    }
+    return i;
+  }
+};
+
+// binary trace, a raw array of TraceRecord
+class TraceReaderBinary : public TraceReaderBase
+{
+protected:
+  FILE *file;
+
+public:
+  TraceReaderBinary(const std::string &fn) : file(fopen(fn.c_str(), "rb")) {}
+  virtual ~TraceReaderBinary() { if(file) fclose(file); }
+
+  bool good() const { return file != nullptr; }
+
+  virtual size_t read(TraceRecord *buf, size_t n) {
+    return file ? fread(buf, sizeof(TraceRecord), n, file) : 0;
+  }
+};
+
+#endif
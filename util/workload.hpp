@@ -0,0 +1,248 @@
+#ifndef CM_UTIL_WORKLOAD_HPP
+#define CM_UTIL_WORKLOAD_HPP
+
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "util/random.hpp"
+#include "util/trace.hpp"
+#include "cache/coherence.hpp"
+
+// Synthetic workload generators
+//   Generators are trace sources producing TraceRecord in batches, so that they can be replayed
+//   by a SweepDriver or issued directly to the core interfaces by workload_run().
+//   Each generator owns a private random engine seeded from cm_get_random_uint64() when it is
+//   constructed, so a workload is reproducible by calling cm_set_random_seed() beforehand.
+//   Common parameters:
+//     ncore:       number of cores issuing the accesses (core ids 0..ncore-1)
+//     total:       number of records to generate, 0 for an endless workload
+//     base:        base address of the accessed region
+//     write_ratio: probability of an access being a write (when the pattern does not decide)
+
+class WorkloadBase : public TraceReaderBase
+{
+protected:
+  const uint32_t ncore;
+  const uint64_t total;
+  const double write_ratio;
+  uint64_t count;          // records generated so far
+  std::mt19937_64 rng;
+
+  bool is_write() { return write_ratio > 0.0 && (rng() >> 11) * 0x1.0p-53 < write_ratio; }
+
+  // generate exactly n records
+  virtual void generate(TraceRecord *buf, size_t n) = 0;
+
+public:
+  WorkloadBase(uint32_t ncore, uint64_t total, double write_ratio)
+    : ncore(ncore), total(total), write_ratio(write_ratio), count(0), rng(cm_get_random_uint64()) { assert(ncore > 0); }
+  virtual ~WorkloadBase() {}
+
+  virtual size_t read(TraceRecord *buf, size_t n) {
+    if(total && n > total - count) n = total - count;
+    generate(buf, n);
+    count += n;
+    return n;
+  }
+
+  uint64_t get_count() const { return count; }
+};
+
+// strided walk: core c walks its own region [base + c*footprint, base + (c+1)*footprint) with a fixed stride
+class WorkloadStrided : public WorkloadBase
+{
+protected:
+  const uint64_t base, footprint, stride;
+  std::vector<uint64_t> offset;  // current offset of each core
+
+public:
+  WorkloadStrided(uint32_t ncore, uint64_t total, uint64_t base, uint64_t footprint, uint64_t stride, double write_ratio = 0.0)
+    : WorkloadBase(ncore, total, write_ratio), base(base), footprint(footprint), stride(stride), offset(ncore, 0) {}
+
+  virtual void generate(TraceRecord *buf, size_t n) {
+    for(size_t i=0; i<n; i++) {
+      uint32_t c = (count + i) % ncore;
+      buf[i].addr = base + c*footprint + offset[c];
+      buf[i].core = c;
+      buf[i].write = is_write();
+      offset[c] += stride;
+      if(offset[c] >= footprint) offset[c] = 0;
+    }
+  }
+};
+
+// sequential walk over blocks (strided by the block size)
+class WorkloadSequential : public WorkloadStrided
+{
+public:
+  WorkloadSequential(uint32_t ncore, uint64_t total, uint64_t base, uint64_t footprint, double write_ratio = 0.0, int block_offset = 6)
+    : WorkloadStrided(ncore, total, base, footprint, 1ull << block_offset, write_ratio) {}
+};
+
+// uniform random blocks in a region shared by all cores, cores issue in round robin
+class WorkloadUniform : public WorkloadBase
+{
+protected:
+  const uint64_t base, nblock;
+  const int block_offset;
+
+public:
+  WorkloadUniform(uint32_t ncore, uint64_t total, uint64_t base, uint64_t footprint, double write_ratio = 0.0, int block_offset = 6)
+    : WorkloadBase(ncore, total, write_ratio), base(base), nblock(footprint >> block_offset), block_offset(block_offset) {}
+
+  virtual void generate(TraceRecord *buf, size_t n) {
+    for(size_t i=0; i<n; i++) {
+      buf[i].addr = base + ((rng() % nblock) << block_offset);
+      buf[i].core = (count + i) % ncore;
+      buf[i].write = is_write();
+    }
+  }
+};
+
+// Zipfian blocks: block of rank k (k = 1..nblock) is accessed with probability ~ 1/k^theta
+//   Ranks are sampled by a binary search over the precomputed CDF and scattered over the
+//   region by a fixed bijective permutation, so that hot blocks do not cluster in a few sets.
+class WorkloadZipf : public WorkloadBase
+{
+protected:
+  const uint64_t base, nblock;
+  const int block_offset;
+  uint64_t mult;               // multiplier of the rank -> block permutation, co-prime with nblock
+  std::vector<double> cdf;
+
+public:
+  WorkloadZipf(uint32_t ncore, uint64_t total, uint64_t base, uint64_t footprint, double theta, double write_ratio = 0.0, int block_offset = 6)
+    : WorkloadBase(ncore, total, write_ratio), base(base), nblock(footprint >> block_offset), block_offset(block_offset), cdf(nblock)
+  {
+    double sum = 0.0;
+    for(uint64_t k=0; k<nblock; k++) cdf[k] = (sum += 1.0 / std::pow(k+1, theta));
+    for(auto &p:cdf) p /= sum;
+    mult = (rng() % nblock) | 1;
+    while(std::gcd(mult, nblock) != 1) mult += 2;
+  }
+
+  virtual void generate(TraceRecord *buf, size_t n) {
+    for(size_t i=0; i<n; i++) {
+      double u = (rng() >> 11) * 0x1.0p-53;
+      uint64_t rank = std::upper_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+      if(rank >= nblock) rank = nblock - 1;
+      buf[i].addr = base + ((unsigned __int128)rank * mult % nblock << block_offset);
+      buf[i].core = (count + i) % ncore;
+      buf[i].write = is_write();
+    }
+  }
+};
+
+// pointer chasing: all blocks of the region form a single random cycle (Sattolo's algorithm),
+// each core follows the cycle from its own starting block
+class WorkloadPointerChase : public WorkloadBase
+{
+protected:
+  const uint64_t base;
+  const int block_offset;
+  std::vector<uint64_t> next;  // next block of the cycle
+  std::vector<uint64_t> cur;   // current block of each core
+
+public:
+  WorkloadPointerChase(uint32_t ncore, uint64_t total, uint64_t base, uint64_t footprint, double write_ratio = 0.0, int block_offset = 6)
+    : WorkloadBase(ncore, total, write_ratio), base(base), block_offset(block_offset), next(footprint >> block_offset), cur(ncore)
+  {
+    uint64_t nblock = next.size();
+    std::vector<uint64_t> order(nblock);
+    std::iota(order.begin(), order.end(), 0);
+    for(uint64_t i=nblock-1; i>0; i--) std::swap(order[i], order[rng() % i]);
+    for(uint64_t i=0; i<nblock; i++) next[order[i]] = order[(i+1) % nblock];
+    for(uint32_t c=0; c<ncore; c++) cur[c] = order[(uint64_t)c * nblock / ncore];
+  }
+
+  virtual void generate(TraceRecord *buf, size_t n) {
+    for(size_t i=0; i<n; i++) {
+      uint32_t c = (count + i) % ncore;
+      buf[i].addr = base + (cur[c] << block_offset);
+      buf[i].core = c;
+      buf[i].write = is_write();
+      cur[c] = next[cur[c]];
+    }
+  }
+};
+
+// producer/consumer sharing: cores are paired (2k produces, 2k+1 consumes, an odd last core is idle),
+// the producer writes the next block of the circular buffer of its pair, then the consumer reads it
+class WorkloadProducerConsumer : public WorkloadBase
+{
+protected:
+  const uint64_t base, footprint;
+  const int block_offset;
+  const uint32_t npair;
+  std::vector<uint64_t> pos;   // current block of each pair
+
+public:
+  // footprint: size of the buffer of each pair
+  WorkloadProducerConsumer(uint32_t ncore, uint64_t total, uint64_t base, uint64_t footprint, int block_offset = 6)
+    : WorkloadBase(ncore, total, 1.0), base(base), footprint(footprint), block_offset(block_offset), npair(ncore/2), pos(ncore/2, 0)
+  {
+    assert(npair > 0);
+  }
+
+  virtual void generate(TraceRecord *buf, size_t n) {
+    uint64_t nblock = footprint >> block_offset;
+    for(size_t i=0; i<n; i++) {
+      uint64_t step = count + i;
+      uint32_t p = (step / 2) % npair;
+      bool produce = (step & 1) == 0;
+      buf[i].addr = base + p*footprint + (pos[p] << block_offset);
+      buf[i].core = 2*p + (produce ? 0 : 1);
+      buf[i].write = produce;
+      if(!produce && ++pos[p] == nblock) pos[p] = 0;
+    }
+  }
+};
+
+// false sharing: every core accesses its own word (8 bytes) of the same blocks
+//   nblock: number of falsely shared blocks, cycled through by all cores
+class WorkloadFalseSharing : public WorkloadBase
+{
+protected:
+  const uint64_t base, nblock;
+  const int block_offset;
+  std::vector<uint64_t> pos;   // current block of each core
+
+public:
+  WorkloadFalseSharing(uint32_t ncore, uint64_t total, uint64_t base, uint64_t nblock, double write_ratio = 1.0, int block_offset = 6)
+    : WorkloadBase(ncore, total, write_ratio), base(base), nblock(nblock), block_offset(block_offset), pos(ncore, 0) {}
+
+  virtual void generate(TraceRecord *buf, size_t n) {
+    uint64_t words = 1ull << (block_offset - 3);
+    for(size_t i=0; i<n; i++) {
+      uint32_t c = (count + i) % ncore;
+      buf[i].addr = base + (pos[c] << block_offset) + (c % words) * 8;
+      buf[i].core = c;
+      buf[i].write = is_write();
+      if(++pos[c] == nblock) pos[c] = 0;
+    }
+  }
+};
+
+// issue up to n records of a trace source to the core interfaces (indexed by core id)
+// return the number of records issued
+inline uint64_t workload_run(TraceReaderBase &src, const std::vector<CoreInterfaceBase *> &cores, uint64_t n, uint64_t *delay, size_t chunk = 4096) {
+  std::vector<TraceRecord> buf(chunk);
+  uint64_t issued = 0;
+  while(issued < n) {
+    size_t m = src.read(buf.data(), std::min<uint64_t>(chunk, n - issued));
+    if(m == 0) break;
+    for(size_t i=0; i<m; i++) {
+      assert(buf[i].core < cores.size());
+      if(buf[i].write) cores[buf[i].core]->write(buf[i].addr, nullptr, delay);
+      else             cores[buf[i].core]->read(buf[i].addr, delay);
+    }
+    issued += m;
+  }
+  return issued;
+}
+
+#endif